@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Stages of the load and frame change paths that heap allocations are attributed to
+enum class AllocPhase : int {
+    Other = 0,  // Anything outside an explicit phase (Qt event handling, thumbnails, ...)
+    Discover,   // Listing series directories
+    Parse,      // Reading DICOM headers and histograms in loadSelectedSeries
+    Decode,     // Decoding pixel data
+    Contour,    // Loading contours and building contour actors
+    SceneBuild, // Building slice actors in createScene
+    Render,     // Rendering a frame
+    Count
+};
+
+// Counters of a single phase
+struct AllocPhaseStats {
+    uint64_t allocations = 0; // Number of operator new calls
+    uint64_t frees = 0;       // Number of operator delete calls
+    uint64_t bytes = 0;       // Total bytes requested
+    uint64_t peakBytes = 0;   // Highest live heap size (all phases) observed while the phase was active
+    uint64_t entries = 0;     // Number of times the phase was entered
+};
+
+// Counts heap allocations per phase. The counting operator new/delete are only compiled in
+// when the build defines DICOMVIEWER_ALLOC_PROFILING, otherwise every call here is a cheap no-op
+// and the statistics stay zero. The active phase is per thread, so worker threads open their
+// own PhaseScope for the work they do on behalf of a phase.
+namespace AllocationProfiler {
+
+// True when the counting allocator is compiled in
+bool enabled();
+
+// Short machine friendly phase name, e.g. "scene_build"
+const char* phaseName(AllocPhase phase);
+
+// Snapshot of one phase
+AllocPhaseStats stats(AllocPhase phase);
+
+// Live heap bytes right now, and the highest value seen since the last reset
+uint64_t currentBytes();
+uint64_t peakBytes();
+
+// Clears all counters, live bytes are kept so frees of older blocks still balance
+void reset();
+
+// Every counter taken at one moment, so several reports of it agree with each other
+struct Snapshot {
+    std::array<AllocPhaseStats, static_cast<size_t>(AllocPhase::Count)> phases;
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;
+};
+Snapshot snapshot();
+
+// All phases as a JSON object, of the current counters or of a snapshot
+std::string toJson();
+std::string toJson(const Snapshot& snapshot);
+
+// Human readable table for the debug overlay, of the current counters or of a snapshot
+std::string summary();
+std::string summary(const Snapshot& snapshot);
+
+// Makes a phase active for the lifetime of the scope and restores the previous phase afterwards
+class PhaseScope {
+public:
+    explicit PhaseScope(AllocPhase phase);
+    ~PhaseScope();
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    AllocPhase m_previous;
+};
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class QJsonObject;
+class QStringList;
+class DicomManager;
+
+// Settings for a headless batch run
+struct BatchOptions {
+    std::string rootPath;   // Directory whose sub-directories are patients (e.g. sa_dicom)
+    std::string outputPath; // Directory receiving per-patient outputs and the run report
+    unsigned jobs = 0;      // Number of worker threads, 0 uses the hardware concurrency
+};
+
+// Outcome and timings of a single patient
+struct PatientResult {
+    std::string name;
+    std::string path;
+    bool success = false;
+    std::string error;
+
+    size_t fileCount = 0;   // .dcm files found before loading, used to balance the workers
+    int seriesCount = 0;
+    int frameCount = 0;
+    int timepointCount = 0;
+    int contourCount = 0;
+    unsigned worker = 0;    // Worker thread that processed the patient
+
+    // Wall clock time per stage in milliseconds
+    double discoverMs = 0.0;
+    double loadMs = 0.0;
+    double contourMs = 0.0;
+    double writeMs = 0.0;
+    double totalMs = 0.0;
+};
+
+// Runs the discoverSeries / loadSelectedSeries / contour path over many patients concurrently
+// and writes a metadata summary and contour metrics per patient plus an overall run report.
+class BatchProcessor {
+public:
+    explicit BatchProcessor(const BatchOptions& options);
+
+    // Processes every patient under the root directory, returns a process exit code
+    int run();
+
+    // Parses "--batch <root> [--output <dir>] [--jobs <n>]" and runs the batch
+    static int runFromCommandLine(const QStringList& arguments);
+
+private:
+    // Loads and measures one patient in place, never throws
+    void processPatient(PatientResult& result, unsigned worker) const;
+
+    // Writes metadata.json and contour_metrics.csv for a loaded patient
+    void writePatientOutputs(const PatientResult& result, const DicomManager& manager,
+                             const QJsonObject& contourSummary, const std::string& contourCsv) const;
+
+    // Writes run_report.json with aggregate throughput and per-patient timings, false on a write error
+    bool writeRunReport(const std::vector<PatientResult>& results, double wallSeconds,
+                        unsigned workers, size_t steals) const;
+
+    // Lists patient directories, largest first so the scheduler starts with the slowest work
+    std::vector<PatientResult> discoverPatients() const;
+
+    BatchOptions m_options;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A closed contour in the pixel coordinates of its slice, as stored in the *_cont.npy files.
+// Loaded once per scene and shared by the contour actor and the cursor probe.
+struct ContourGeometry {
+    std::vector<double> x; // Column coordinates of the contour points
+    std::vector<double> y; // Row coordinates of the contour points
+
+    // Bounding box in pixel coordinates, used to reject most point tests early
+    double minX = 0.0;
+    double maxX = 0.0;
+    double minY = 0.0;
+    double maxY = 0.0;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.size() < 2; }
+
+    // Recomputes the bounding box after the points changed
+    void updateBounds();
+
+    // Even-odd point in polygon test in pixel coordinates, the last point connects to the first
+    bool contains(double px, double py) const;
+
+    // Enclosed area in mm^2 (shoelace formula), given the pixel spacing of the slice
+    double area(double spacingX, double spacingY) const;
+
+    // Length of the closed outline in mm
+    double perimeter(double spacingX, double spacingY) const;
+
+    // Loads a (2, N) numpy array of contour points, returns false if the file is missing or malformed
+    static bool loadFromNpy(const std::string& path, ContourGeometry& contour);
+};
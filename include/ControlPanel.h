@@ -7,6 +7,8 @@ class QPushButton;
 class QSlider;
 class QLabel;
 class QCheckBox;
+class QComboBox;
+class QStringList;
 
 class ControlPanel : public QWidget {
     Q_OBJECT // Qt macro required for any class that uses signals/slots
@@ -20,14 +22,24 @@ public:
     void setControlsEnabled(bool enabled); // Enables/disables all controls in the panel
     void updateFrameLabel(int currentFrame, int maxFrame); // Updates the frame label text
     QSlider* getFrameSlider() const; // Getter method for the frame slider widget 
+    void setWindowPresets(const QStringList& names); // Replaces the window/level preset choices, without emitting windowPresetChanged
+    void setPlaying(bool playing); // Updates the play button without emitting playToggled
 
 signals:
     void loadPatientClicked(); // Signal emitted when the load patient button is clicked
     void transparencyToggled(bool isTransparent); // Signal emitted when transparency toggle checkbox changes state
+    void windowPresetChanged(int index); // Signal emitted when a different window/level preset is picked
+    void playToggled(bool playing); // Signal emitted when cine playback is started or stopped
+    void smoothCineToggled(bool smooth); // Signal emitted when interpolation between timepoints is switched
+    void slowMotionChanged(int factor); // Signal emitted with the new slow motion factor (1, 2, 4, 8)
 
 private:
     QPushButton* m_loadPatientButton; // Button to trigger patient data loading
     QSlider* m_frameSlider; // Slider for navigating through frames
     QLabel* m_frameLabel; // Displays current frame information
     QCheckBox* m_transparencyToggle; // Checkbox to toggle transparency mode
+    QComboBox* m_windowPresetBox; // Window/level presets of the loaded study
+    QPushButton* m_playButton; // Starts and stops cine playback
+    QCheckBox* m_smoothCineToggle; // Interpolates frames between timepoints during playback
+    QComboBox* m_slowMotionBox; // Playback slow motion factor
 };
\ No newline at end of file
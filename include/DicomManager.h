@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include "IntensityHistogram.h"
 
 // Represents a frame in a DICOM series, including the contour
 struct DicomFrame {
@@ -28,6 +29,13 @@ struct DicomFrame {
 // alias for a vector of DicomFrames, representing a single time series.
 using DicomSeries = std::vector<DicomFrame>;
 
+// A display window derived from the intensity histogram, in stored pixel values like the displayed slices
+struct WindowLevelPreset {
+    std::string name;
+    double window = 1000.0;
+    double level = 500.0;
+};
+
 // Manages all DICOM file discovery, parsing, and data organization.
 class DicomManager {
 public:
@@ -45,6 +53,26 @@ public:
     
     // return length of longest time series
     int getNumberOfFrames() const;
+
+    // All loaded series, keyed by the full path to the series folder
+    const std::map<std::string, DicomSeries>& getSeries() const;
+
+    // Decodes the pixels of a frame with the modality rescale applied, writing rows * cols values row by row
+    static bool decodeFrame(const DicomFrame& frame, float* pixels);
+
+    // Percentile based window/level presets over all loaded series, computed during loading
+    const std::vector<WindowLevelPreset>& getWindowPresets() const;
+
+    // Presets of a single series, keyed like getSeries(), empty if the series is unknown or
+    // per series presets are off
+    std::vector<WindowLevelPreset> getSeriesWindowPresets(const std::string& seriesPath) const;
+
+    // Whether loading also derives presets per series (off by default, the viewer only offers
+    // the study presets). Takes effect on the next load.
+    void setSeriesWindowPresets(bool enabled);
+
+    // Number of threads used to parse files, 0 uses the hardware concurrency
+    void setParseThreads(unsigned threads);
     
     // clear previous data
     void clear();
@@ -52,4 +80,24 @@ public:
 private:
     // Stores all loaded series data, keyed by the full path to the series folder.
     std::map<std::string, DicomSeries> m_seriesMap;
+
+    // Window/level presets per series and for the whole study
+    std::map<std::string, std::vector<WindowLevelPreset>> m_seriesPresets;
+    std::vector<WindowLevelPreset> m_windowPresets;
+
+    unsigned m_parseThreads = 0;
+    bool m_seriesWindowPresets = false;
+
+    // Pixel format of a file, decides the histogram layout of its series
+    struct PixelInfo {
+        int bitsStored = 0;
+        bool isSigned = false;
+    };
+
+    // Parses one file, returns false if an essential tag is missing
+    static bool parseFile(const std::string& filePath, DicomFrame& frame, PixelInfo& pixelInfo,
+                          IntensityHistogram& histogram);
+
+    // Percentile presets of a histogram
+    static std::vector<WindowLevelPreset> createWindowPresets(const IntensityHistogram& histogram);
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Exact histogram of stored pixel values. One bin per representable value, sized from the
+// DICOM Bits Stored tag, so a typical 12 bit MR series needs only 4096 bins and worker
+// threads can afford a private histogram per series that is merged once at the end.
+class IntensityHistogram {
+public:
+    // Prepares bins for values with the given number of stored bits (clamped to 1..16)
+    void reset(int bitsStored, bool isSigned);
+
+    bool empty() const { return m_total == 0; }
+    uint64_t total() const { return m_total; }
+    int bitsStored() const { return m_bitsStored; }
+    bool isSigned() const { return m_signed; }
+
+    // Counts raw stored values, out of range values land in the first or last bin
+    void add(const uint8_t* values, size_t count);
+    void add(const uint16_t* values, size_t count);
+    void add(const int16_t* values, size_t count);
+
+    // Counts 16 bit pixel cells holding bitsStored() bits that end at highBit. Bits outside the
+    // stored range are dropped, and signed values are sign extended from highBit, so overlay
+    // or garbage bits in the cell cannot push values into the wrong bin.
+    void addStored(const uint16_t* cells, size_t count, int highBit);
+
+    // Adds the counts of another histogram, which may use a different bit depth
+    void merge(const IntensityHistogram& other);
+
+    // Smallest stored value such that at least fraction of all pixels are <= it
+    double percentile(double fraction) const;
+
+private:
+    // Stored value of a bin and bin of a stored value
+    int binValue(size_t bin) const { return static_cast<int>(bin) + m_offset; }
+    size_t valueBin(int value) const;
+
+    std::vector<uint32_t> m_counts;
+    uint64_t m_total = 0;
+    int m_bitsStored = 0;
+    bool m_signed = false;
+    int m_offset = 0; // Value of bin 0, negative for signed data
+};
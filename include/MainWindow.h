@@ -1,12 +1,16 @@
 #pragma once
 
 #include <QMainWindow> // Base class for main window
+#include <utility>
+#include <vector>
 #include "DicomManager.h"
 #include "VtkManager.h"
 
 // Forward declarations
 class QVTKOpenGLNativeWidget; // QT widget that embeds VTK rendering
 class ControlPanel; // Custom control panel UI component
+class VolumeServer; // Publishes the loaded study to local analysis tools
+class QTimer; // Drives cine playback
 
 /**
  * The main application window class that coordinates all components.
@@ -20,15 +24,32 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Starts publishing loaded studies on a local socket, see VolumeServer for the protocol
+    bool startVolumeServer(const QString& name);
+
+    // Shows allocation counts per phase in a debug overlay and writes them to a JSON file
+    void enableAllocationReport(const QString& jsonPath);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override; // Watches mouse movement over the 3D view
+
 private slots:
     // Slots are methods that respond to specific signals (events)
     void onLoadPatient(); // Handles the "Load Patient" button click event
     void onSliderMoved(int frameIndex);  // Responds to frame slider movement
     void onSliderReleased(); // Responds to frame slider release
     void onTransparencyToggled(bool isTransparent); // Handles transparency toggle checkbox state changes
+    void onWindowPresetChanged(int index); // Applies a window/level preset of the loaded study
+    void onPlayToggled(bool playing); // Starts or stops cine playback
+    void onCineTick(); // Advances playback by one displayed frame
 
 private:
     void setupConnections(); // Establishes communication between UI components and application logic
+    void updateProbeReadout(const QPoint& widgetPos); // Shows what lies under the cursor in the status bar
+    void showTimepoint(int frameIndex); // Builds and renders the scene of a timepoint
+    const std::vector<DicomFrame>& timepointFrames(int frameIndex); // Cached getFramesForTimepoint
+    void updateAllocationReport(); // Refreshes allocation statistics after a load or frame change
+    void stopPlayback(); // Stops the cine timer and resets the play button
 
     // UI Components
     QVTKOpenGLNativeWidget* m_vtkWidget; // Widget that hosts VTK visualization
@@ -37,4 +58,15 @@ private:
     // Core Logic and Data Components
     DicomManager m_dicomManager; // Handles DICOM file loading and management
     VtkManager m_vtkManager; // Manages VTK visualization pipeline and rendering
+    VolumeServer* m_volumeServer = nullptr; // Only created in server mode
+    QString m_allocationReportPath; // Empty unless allocation reporting is enabled
+
+    // Cine playback
+    QTimer* m_cineTimer; // Fires once per displayed frame
+    double m_cinePosition = 0.0; // Fractional timepoint being shown
+    int m_cineDisplayedFrame = -1; // Timepoint of the last regular scene built during playback
+    std::pair<int, int> m_cinePair{-1, -1}; // Timepoints of the interpolated scene on screen, -1 if none
+    std::vector<std::vector<DicomFrame>> m_timepointFrames; // Slices per timepoint of the loaded study
+    bool m_smoothCine = false; // Interpolate between timepoints instead of stepping
+    int m_slowMotion = 1; // Playback is this many times slower than real time
 };
\ No newline at end of file
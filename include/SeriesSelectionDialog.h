@@ -7,18 +7,24 @@
 // Forward declarations
 class QListWidget; // Qt widget for displaying a list of selectable items
 class QDialogButtonBox; // Qt widget for standard dialog buttons (OK, Cancel, etc.)
+class QImage;
+class ThumbnailLoader; // Background generator for series previews
 
 // Dialog window for user to select DICOM series from a list. 
 class SeriesSelectionDialog : public QDialog {
     Q_OBJECT
 
 public:
-    explicit SeriesSelectionDialog(const std::vector<std::string>& seriesNames, QWidget *parent = nullptr);
+    explicit SeriesSelectionDialog(const std::string& patientPath, const std::vector<std::string>& seriesNames, QWidget *parent = nullptr);
     ~SeriesSelectionDialog();
 
     std::vector<std::string> getSelectedSeries() const; // Gives a vector of series selected by user
 
+private slots:
+    void onThumbnailReady(int row, const QImage& image); // Shows a finished thumbnail next to its series
+
 private:
     QListWidget* m_listWidget; // Widget displaying the list of series for selection
     QDialogButtonBox* m_buttonBox; // Container for standard dialog buttons (OK/Cancel)
+    ThumbnailLoader* m_thumbnailLoader; // Decodes series previews off the GUI thread
 };
\ No newline at end of file
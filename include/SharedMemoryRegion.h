@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Owns a named POSIX shared memory object mapped into this process. Other processes open it
+// by name with shm_open and mmap it read-only, so pixel buffers are shared without copying.
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    // Creates and maps a new object, the name must start with '/' and must not exist yet
+    bool create(const std::string& name, size_t size);
+
+    // Unmaps and unlinks the object. Clients that already mapped it keep their mapping.
+    void release();
+
+    void* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::string& name() const { return m_name; }
+
+private:
+    std::string m_name;
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
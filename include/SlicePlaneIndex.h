@@ -0,0 +1,72 @@
+#pragma once
+
+#include <eigen3/Eigen/Dense>
+#include <vector>
+
+// A slice rectangle placed in world space, taken from the same transform used to place its actor
+struct SlicePlane {
+    Eigen::Vector3d origin{0.0, 0.0, 0.0}; // World position of the first pixel
+    Eigen::Vector3d row{1.0, 0.0, 0.0};    // Unit direction of increasing column index
+    Eigen::Vector3d col{0.0, 1.0, 0.0};    // Unit direction of increasing row index
+    Eigen::Vector3d normal{0.0, 0.0, 1.0}; // row x col
+
+    // Local extent of the slice in mm, along row and col
+    double minU = 0.0;
+    double maxU = 0.0;
+    double minV = 0.0;
+    double maxV = 0.0;
+
+    int sliceIndex = -1; // Index of the slice in the current scene
+};
+
+// Result of a spatial query against the index
+struct SliceHit {
+    int sliceIndex = -1;
+    double distance = 0.0;         // Ray parameter for ray queries, distance to the plane for point queries
+    Eigen::Vector3d world{0.0, 0.0, 0.0}; // Hit point on the slice
+    double u = 0.0;                // Local coordinates of the hit in mm
+    double v = 0.0;
+};
+
+// Bounding volume hierarchy over slice rectangles, so a cursor query only visits the few
+// slices near the ray instead of every actor in the scene.
+class SlicePlaneIndex {
+public:
+    // Rebuilds the hierarchy for a new set of planes
+    void build(const std::vector<SlicePlane>& planes);
+
+    // Removes all planes
+    void clear();
+
+    bool empty() const { return m_planes.empty(); }
+
+    // Finds the nearest slice hit by the ray origin + t * direction with t >= 0
+    bool intersectRay(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, SliceHit& hit) const;
+
+    // Finds the slice closest to a world point, within tolerance mm of its plane
+    bool closestSlice(const Eigen::Vector3d& point, double tolerance, SliceHit& hit) const;
+
+private:
+    // Flat BVH node, leaves reference a range of m_planes
+    struct Node {
+        double boxMin[3];
+        double boxMax[3];
+        int left = -1;  // Child node indices, -1 for leaves
+        int right = -1;
+        int first = 0;  // First plane of a leaf
+        int count = 0;  // Number of planes in a leaf
+    };
+
+    // Recursively splits planes [first, first + count) at the median centroid of the longest axis
+    int buildNode(int first, int count, std::vector<Eigen::Vector3d>& centroids);
+
+    // Computes the world space bounds of a slice rectangle
+    static void planeBounds(const SlicePlane& plane, double boxMin[3], double boxMax[3]);
+
+    // Tests a ray against a single rectangle, updating hit when closer than maxT
+    static bool intersectPlane(const SlicePlane& plane, const Eigen::Vector3d& origin,
+                               const Eigen::Vector3d& direction, double maxT, SliceHit& hit);
+
+    std::vector<SlicePlane> m_planes; // Reordered so that leaves reference contiguous ranges
+    std::vector<Node> m_nodes;        // Root is m_nodes[0]
+};
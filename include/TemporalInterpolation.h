@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include "ContourGeometry.h"
+
+// Kernels for synthesising frames between two neighbouring timepoints of a cine series.
+// The blends are vectorised (AVX when the CPU has it, SSE2 or NEON otherwise) and cheap
+// enough to run for every displayed frame, so nothing is precomputed for the whole study.
+namespace TemporalInterpolation {
+
+// out[i] = a[i] + alpha * (b[i] - a[i]) for float pixel buffers, out may alias a or b
+void blendImages(const float* a, const float* b, float* out, size_t count, float alpha);
+
+// Same blend for double buffers such as interleaved xyz contour points
+void blendPoints(const double* a, const double* b, double* out, size_t count, double alpha);
+
+// Resamples a closed contour to pointCount points evenly spaced along its outline
+ContourGeometry resampleContour(const ContourGeometry& contour, size_t pointCount);
+
+// Gives target the winding direction of reference and rotates its points so that the
+// first point is the one closest to the first point of reference. Both must have the
+// same point count, afterwards point i of one corresponds to point i of the other.
+void alignContour(const ContourGeometry& reference, ContourGeometry& target);
+
+// Resamples both contours to the larger point count and aligns b to a
+void matchContours(const ContourGeometry& a, const ContourGeometry& b,
+                   ContourGeometry& matchedA, ContourGeometry& matchedB);
+
+}
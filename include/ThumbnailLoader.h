@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QObject> // Base class for objects that emit signals
+#include <QImage>
+#include <QString>
+#include <memory>
+#include <string>
+
+// Generates downsampled middle-slice previews of DICOM series on a background thread pool.
+// Finished thumbnails are cached on disk, so reopening a patient only costs a PNG read.
+class ThumbnailLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailLoader(int thumbnailSize, QObject *parent = nullptr);
+    ~ThumbnailLoader();
+
+    // Queues a thumbnail for the series folder, thumbnailReady is delivered on the GUI thread
+    void request(int row, const std::string& seriesPath);
+
+    // Stops delivering thumbnails and turns queued tasks into no-ops, returns without waiting
+    // for tasks that are already decoding
+    void cancel();
+
+    // Loads the cached thumbnail or decodes the middle slice, safe to call from any thread
+    static QImage loadOrGenerate(const std::string& seriesPath, int thumbnailSize);
+
+    struct SharedState; // Cancel flag and back pointer, outlives the loader while tasks run
+
+signals:
+    void thumbnailReady(int row, const QImage& image); // Emitted once per successful request
+
+private:
+    // Picks the middle .dcm file of a series folder (by file name), empty if there is none
+    static std::string findMiddleSlice(const std::string& seriesPath);
+
+    // Location of the cached PNG, keyed on file path, modification time and thumbnail size
+    static QString cachePathFor(const std::string& filePath, int thumbnailSize);
+
+    // Decodes a DICOM file and scales it so its longest side is thumbnailSize pixels
+    static QImage decodeThumbnail(const std::string& filePath, int thumbnailSize);
+
+    std::shared_ptr<SharedState> m_shared; // Shared with queued tasks
+    int m_thumbnailSize; // Longest side of generated thumbnails, in pixels
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QObject> // Base class for objects that use signals/slots
+#include <QJsonObject>
+#include <QString>
+#include <map>
+#include <memory>
+#include <set>
+#include "ContourGeometry.h"
+#include "SharedMemoryRegion.h"
+
+// Forward declarations
+class QLocalServer; // Qt server for local (Unix domain) sockets
+class DicomManager;
+
+// Publishes the loaded study to local analysis tools. Metadata travels over a Unix domain
+// socket as newline delimited JSON, decoded pixels are placed in POSIX shared memory once per
+// timepoint so clients can map them without copying or decoding the DICOM files again.
+//
+// Requests and responses are single-line JSON objects:
+//   {"cmd":"info"}                               study summary
+//   {"cmd":"timepoint","index":t}                frame metadata and the shared memory name of timepoint t
+//   {"cmd":"set_contour","timepoint":t,"slice":s,"x":[...],"y":[...]}
+//                                                replaces a contour (pixel coordinates) in the viewer
+//   {"cmd":"release","index":t}                  drops this connection's hold on timepoint t
+// Every response carries "ok", failed requests add an "error" message.
+//
+// Published pixels are modality values (rescale slope and intercept applied), not the stored
+// values the viewer displays. A region is unlinked once every connection that requested it has
+// released it or disconnected.
+class VolumeServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VolumeServer(const DicomManager& dicomManager, QObject *parent = nullptr);
+    ~VolumeServer();
+
+    // Starts listening, a name without a '/' is placed in the system temp directory. Fails when
+    // another live server already answers on the name, a stale socket is replaced.
+    bool listen(const QString& name);
+
+    // Full path of the socket clients connect to
+    QString serverName() const;
+
+    // Unlinks all published buffers, called whenever a different study is loaded
+    void studyChanged();
+
+    // Handles a single protocol message, returns the response object. Timepoints are held on
+    // behalf of client, null stands for in-process callers.
+    QJsonObject handleRequest(const QJsonObject& request, const QObject* client = nullptr);
+
+signals:
+    void contourWritten(const QString& filePath, const ContourGeometry& contour); // A client replaced a contour
+
+private slots:
+    void onNewConnection(); // Accepts a client connection
+    void onReadyRead();     // Processes every complete request line of a client
+    void onDisconnected();  // Releases everything the client still holds
+
+private:
+    QJsonObject handleInfo() const;
+    QJsonObject handleTimepoint(const QJsonObject& request, const QObject* client);
+    QJsonObject handleSetContour(const QJsonObject& request);
+    QJsonObject handleRelease(const QJsonObject& request, const QObject* client);
+
+    // Drops the client's hold on every timepoint, unlinking regions nobody holds any more
+    void releaseClient(const QObject* client);
+
+    // A published timepoint and the connections that requested it
+    struct PublishedTimepoint {
+        std::unique_ptr<SharedMemoryRegion> region;
+        std::set<const QObject*> clients;
+    };
+
+    QLocalServer* m_server; // Listening socket
+    const DicomManager& m_dicomManager; // Source of frame metadata
+    std::map<int, PublishedTimepoint> m_regions; // Published pixel buffers by timepoint
+    int m_generation = 0; // Bumped per study so shared memory names are never reused
+};
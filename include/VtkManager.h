@@ -2,7 +2,11 @@
 
 #include <vtkSmartPointer.h>
 #include <vector>
+#include <map>
+#include <string>
 #include "DicomManager.h" // Include DicomManager to get the DicomFrame definition
+#include "ContourGeometry.h"
+#include "SlicePlaneIndex.h"
 
 // Forward declarations to keep this header lightweight.
 class vtkRenderer;                   // VTK class for managing the rendering process
@@ -12,6 +16,21 @@ class vtkMatrix4x4;                  // VTK class for 4x4 transformation matrice
 class QVTKOpenGLNativeWidget;        // Qt widget that embeds VTK rendering
 class vtkImageProperty;              // VTK class for controlling image appearance properties
 class vtkActor;                      // VTK base class for objects in the rendered scene
+class vtkImageData;                  // VTK class for decoded image volumes
+class vtkTextActor;                  // VTK actor for 2D text overlays
+class vtkPoints;                     // VTK container for 3D point coordinates
+
+// Everything known about the scene point under the mouse cursor
+struct ProbeResult {
+    bool hit = false;          // False when the cursor is not over any slice
+    double world[3] = {0.0, 0.0, 0.0}; // World coordinate of the hit in mm
+    int sliceIndex = -1;       // Slice within the current scene, ordered like createScene's frames
+    int pixelI = 0;            // Column of the pixel under the cursor
+    int pixelJ = 0;            // Row of the pixel under the cursor
+    double intensity = 0.0;    // Stored pixel value
+    bool hasContour = false;   // Whether the slice has a contour at all
+    bool insideContour = false;
+};
 
 class VtkManager {
 public:
@@ -24,6 +43,14 @@ public:
 
     // Clears scence and builds a new one from the vector of Dicom frames
     void createScene(const std::vector<DicomFrame>& frames);
+
+    // Clears the scene and builds one that shows frames between two timepoints. Images are
+    // blended and contours interpolated point by point, see setInterpolationAlpha.
+    void setInterpolatedFrames(const std::vector<DicomFrame>& framesA, const std::vector<DicomFrame>& framesB);
+
+    // Moves the interpolated scene to alpha (0 = framesA, 1 = framesB). Only re-runs the blend
+    // kernels on the existing actors, cheap enough for every displayed frame.
+    void setInterpolationAlpha(double alpha);
     
     // Resets the camera to frame all the actors in the scene.
     void resetCamera();
@@ -31,11 +58,52 @@ public:
     // Sets the opacity value of slices
     void setSliceOpacity(double opacity);
 
+    // Sets the display window of all slices, a property change only, no pixels are touched
+    void setWindowLevel(double window, double level);
+
+    // Looks up the slice, pixel and contour state under a display (VTK pixel) coordinate
+    bool probe(double displayX, double displayY, ProbeResult& result) const;
+
+    // Replaces the contour of a DICOM file. The override is used by later scenes as well,
+    // and updates the current scene in place when the file is on screen.
+    void overrideContour(const std::string& filePath, const ContourGeometry& contour);
+
+    // Drops all contour overrides, used when a new patient is loaded
+    void clearContourOverrides();
+
+    // Contour actor of a slice in the current regular scene, null when the slice has no contour
+    vtkActor* contourActor(size_t sliceIndex) const;
+
+    // Shows text in the top left corner of the view, an empty string hides it
+    void setDebugOverlayText(const std::string& text);
+
+    // Create contour actors from contour points in pixel coordinates, null for empty contours
+    vtkSmartPointer<vtkActor> createContourActor(const DicomFrame& frame, const ContourGeometry& contour);
+
 
 private:
     // Creates transformation matrix from position and orientation data
     vtkSmartPointer<vtkMatrix4x4> createTransformMatrix(const DicomFrame& frame);
 
+    // Describes the world space rectangle of a slice, using the transform from createTransformMatrix
+    static SlicePlane createSlicePlane(const DicomFrame& frame, vtkMatrix4x4* transform, int sliceIndex);
+
+    // Removes all actors and per slice data of the current scene
+    void clearScene();
+
+    // Contour of a frame, a written back override wins over the npy file
+    void loadSliceContour(const DicomFrame& frame, ContourGeometry& contour) const;
+
+    // Float copy of a frame's flipped image, reused from previous when it was loaded before
+    vtkSmartPointer<vtkImageData> loadFloatImage(const DicomFrame& frame,
+                                                 std::map<std::string, vtkSmartPointer<vtkImageData>>& previous);
+
+    // Builds actors for an interpolated scene between two sets of frames
+    void buildBlendScene(const std::vector<DicomFrame>& framesA, const std::vector<DicomFrame>& framesB);
+
+    // Runs the blend kernels for one displayed frame
+    void updateBlend(double alpha);
+
     // Core VTK rendering objects
     vtkSmartPointer<vtkRenderer> m_renderer;
     vtkSmartPointer<vtkGenericOpenGLRenderWindow> m_renderWindow;
@@ -43,12 +111,46 @@ private:
     // A single property object to control the appearance of all slices
     vtkSmartPointer<vtkImageProperty> m_imageProperty;
 
-    // Create contour actors
-    vtkSmartPointer<vtkActor> createContourActor(const DicomFrame& frame);
-
-    // Track contour actors
+    // Track contour actors, one entry per slice (null when the slice has no contour)
     std::vector<vtkSmartPointer<vtkActor>> m_contourActors;
 
+    // Contours written by other tools, keyed by DICOM file path, take precedence over the npy files
+    std::map<std::string, ContourGeometry> m_contourOverrides;
+
     // A list to keep track of the actors we've added to the scene
     std::vector<vtkSmartPointer<vtkImageActor>> m_sliceActors;
+
+    // Per slice data kept for cursor probing, indexed like m_sliceActors
+    std::vector<DicomFrame> m_sliceFrames;
+    std::vector<vtkSmartPointer<vtkImageData>> m_sliceImages;
+    std::vector<ContourGeometry> m_sliceContours;
+
+    // Spatial index over the slice rectangles of the current scene
+    SlicePlaneIndex m_sliceIndex;
+
+    // 2D text drawn over the scene, e.g. allocation statistics
+    vtkSmartPointer<vtkTextActor> m_debugOverlay;
+
+    // A slice of an interpolated scene, with everything the per frame blend needs
+    struct BlendSlice {
+        vtkSmartPointer<vtkImageData> imageA;  // Float pixels of both timepoints
+        vtkSmartPointer<vtkImageData> imageB;
+        vtkSmartPointer<vtkImageData> blended; // Shown by the slice actor, rewritten per frame
+        ContourGeometry contourA;              // Resampled to matched point counts, aligned point by point
+        ContourGeometry contourB;
+        std::vector<float> worldA;             // Interleaved xyz world coordinates of the matched contours
+        std::vector<float> worldB;
+        vtkSmartPointer<vtkPoints> contourPoints; // Points of the interpolated contour actor
+        vtkSmartPointer<vtkActor> nearestA;    // Used when only one timepoint has a contour
+        vtkSmartPointer<vtkActor> nearestB;
+    };
+
+    // Interpolated scene state, empty while a regular scene is shown
+    std::vector<BlendSlice> m_blendSlices;
+    std::vector<DicomFrame> m_blendFramesA; // Matched frames per slice, kept to rebuild after a contour override
+    std::vector<DicomFrame> m_blendFramesB;
+    double m_blendAlpha = 0.0;              // Last alpha shown
+
+    // Float images of the timepoints in use, so stepping to the next pair decodes only one timepoint
+    std::map<std::string, vtkSmartPointer<vtkImageData>> m_floatImageCache;
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs a batch of independent tasks on a fixed set of worker threads. Each worker owns a
+// deque, works on its own tasks from the back and steals from the front of other workers'
+// deques once it runs dry, so a few large patients do not leave the other workers idle.
+class WorkStealingScheduler {
+public:
+    // A task receives the index of the worker thread that runs it
+    using Task = std::function<void(unsigned worker)>;
+
+    // A worker count of 0 uses the hardware concurrency
+    explicit WorkStealingScheduler(unsigned workerCount = 0);
+
+    // Runs every task to completion. Tasks are dealt round-robin in the given order,
+    // so callers should put the most expensive tasks first.
+    void run(std::vector<Task> tasks);
+
+    unsigned workerCount() const { return m_workerCount; }
+
+    // Number of tasks taken from another worker's deque during the last run
+    size_t stealCount() const { return m_steals.load(); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // Main loop of a worker thread
+    void workerLoop(unsigned worker);
+
+    // Takes the next task of a worker, falling back to stealing, returns false when all queues are empty
+    bool nextTask(unsigned worker, Task& task);
+
+    unsigned m_workerCount;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::atomic<size_t> m_steals{0};
+};
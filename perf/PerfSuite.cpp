@@ -0,0 +1,422 @@
+// Performance regression suite. Generates a fixed synthetic study, times the load and scene
+// paths on it and compares heap allocations with the baseline in perf/baselines and median times
+// with a machine local baseline that the first run records. Exit codes: 0 within tolerance,
+// 1 regression or missing allocation baseline, 2 setup error, 77 nothing to compare (skipped).
+
+#include "AllocationProfiler.h"
+#include "ContourGeometry.h"
+#include "DicomManager.h"
+#include "SyntheticStudy.h"
+#include "VtkManager.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <vtkActor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr int kRegressionReturnCode = 1;
+constexpr int kSetupErrorReturnCode = 2;
+constexpr int kSkipReturnCode = 77;     // SKIP_RETURN_CODE of the CTest entries
+constexpr unsigned kParseThreads = 2;   // Fixed so allocation counts do not depend on the machine
+
+// Results end up here so the measured calls cannot be optimised away
+volatile size_t g_sink = 0;
+
+// Measurements of one benchmark
+struct BenchmarkResult {
+    std::string name;
+    double medianMs = 0.0;
+    double minMs = 0.0;
+    uint64_t allocations = 0; // Per repetition
+    uint64_t bytes = 0;       // Per repetition
+};
+
+// Milliseconds elapsed since start
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Sums the allocation counters of all phases
+void totalAllocations(uint64_t& allocations, uint64_t& bytes) {
+    allocations = 0;
+    bytes = 0;
+    for (int phase = 0; phase < static_cast<int>(AllocPhase::Count); ++phase) {
+        AllocPhaseStats stats = AllocationProfiler::stats(static_cast<AllocPhase>(phase));
+        allocations += stats.allocations;
+        bytes += stats.bytes;
+    }
+}
+
+// Runs body once to warm caches, then repetitions timed runs. The allocation counts come
+// from the last run, by then every lazily created object exists.
+BenchmarkResult measure(const std::string& name, int repetitions, const std::function<void()>& body) {
+    body();
+
+    BenchmarkResult result;
+    result.name = name;
+    std::vector<double> times;
+    for (int i = 0; i < repetitions; ++i) {
+        AllocationProfiler::reset();
+        Clock::time_point start = Clock::now();
+        body();
+        times.push_back(elapsedMs(start));
+        totalAllocations(result.allocations, result.bytes);
+    }
+
+    std::sort(times.begin(), times.end());
+    result.medianMs = times[times.size() / 2];
+    result.minMs = times.front();
+    return result;
+}
+
+// Runs every benchmark on a loaded study, returns false when the study did not load as expected
+bool runBenchmarks(const SyntheticStudySpec& spec, const std::string& studyPath, int repetitions,
+                   std::vector<BenchmarkResult>& results) {
+    DicomManager dicomManager;
+    dicomManager.setParseThreads(kParseThreads);
+    std::vector<std::string> seriesNames = dicomManager.discoverSeries(studyPath);
+
+    results.push_back(measure("load_selected_series", repetitions, [&] {
+        g_sink = g_sink + dicomManager.loadSelectedSeries(studyPath, seriesNames);
+    }));
+    int numFrames = dicomManager.getNumberOfFrames();
+    if (numFrames != spec.timepoints || static_cast<int>(dicomManager.getSeries().size()) != spec.seriesCount) {
+        std::cerr << "Error: Study " << spec.name << " loaded " << dicomManager.getSeries().size() << " series with "
+                  << numFrames << " frames, expected " << spec.seriesCount << " with " << spec.timepoints << std::endl;
+        return false;
+    }
+
+    results.push_back(measure("get_frames_for_timepoint", repetitions, [&] {
+        for (int t = 0; t < numFrames; ++t) {
+            g_sink = g_sink + dicomManager.getFramesForTimepoint(t).size();
+        }
+    }));
+
+    // Contours are read up front, the benchmark covers building the actors only
+    std::vector<std::vector<DicomFrame>> timepoints;
+    std::vector<std::pair<DicomFrame, ContourGeometry>> contours;
+    for (int t = 0; t < numFrames; ++t) {
+        timepoints.push_back(dicomManager.getFramesForTimepoint(t));
+        for (const auto& frame : timepoints.back()) {
+            ContourGeometry contour;
+            ContourGeometry::loadFromNpy(frame.contourFilePath, contour);
+            contours.emplace_back(frame, contour);
+        }
+    }
+
+    VtkManager vtkManager;
+    results.push_back(measure("create_contour_actor", repetitions, [&] {
+        for (const auto& entry : contours) {
+            g_sink = g_sink + (vtkManager.createContourActor(entry.first, entry.second) != nullptr);
+        }
+    }));
+
+    // One repetition steps through the whole cycle like releasing the slider on every frame
+    results.push_back(measure("create_scene", repetitions, [&] {
+        for (const auto& frames : timepoints) {
+            vtkManager.createScene(frames);
+        }
+    }));
+    return true;
+}
+
+// Loads a JSON object from disk, false if the file is missing or not valid JSON
+bool readJson(const QString& path, QJsonObject& object) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject()) {
+        std::cerr << "Error: " << path.toStdString() << " is not a JSON object." << std::endl;
+        return false;
+    }
+    object = document.object();
+    return true;
+}
+
+// Writes a JSON object to disk, creating the directory if needed
+bool writeJson(const QString& path, const QJsonObject& object) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    QByteArray data = QJsonDocument(object).toJson(QJsonDocument::Indented);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) != data.size() || !file.flush()) {
+        std::cerr << "Error: Cannot write " << path.toStdString() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Writes the allocation counts as the new committed baseline, keeping per benchmark tolerance overrides.
+// Counts only depend on the code and the study, so one file serves every machine.
+bool writeAllocationBaseline(const QString& path, const SyntheticStudySpec& spec,
+                             const std::vector<BenchmarkResult>& results) {
+    QJsonObject previous;
+    readJson(path, previous);
+    QJsonObject previousBenchmarks = previous["benchmarks"].toObject();
+
+    QJsonObject benchmarks;
+    for (const auto& result : results) {
+        QString name = QString::fromStdString(result.name);
+        QJsonObject entry = previousBenchmarks[name].toObject();
+        entry["allocations"] = static_cast<double>(result.allocations);
+        entry["bytes"] = static_cast<double>(result.bytes);
+        benchmarks[name] = entry;
+    }
+
+    QJsonObject baseline;
+    baseline["study"] = QString::fromStdString(spec.name);
+    baseline["allocationProfiling"] = true;
+    baseline["parseThreads"] = static_cast<int>(kParseThreads);
+    baseline["benchmarks"] = benchmarks;
+    return writeJson(path, baseline);
+}
+
+// Writes the times as the new machine local baseline, keeping per benchmark tolerance overrides
+bool writeTimingBaseline(const QString& path, const SyntheticStudySpec& spec, int repetitions,
+                         const std::vector<BenchmarkResult>& results) {
+    QJsonObject previous;
+    readJson(path, previous);
+    QJsonObject previousBenchmarks = previous["benchmarks"].toObject();
+
+    QJsonObject benchmarks;
+    for (const auto& result : results) {
+        QString name = QString::fromStdString(result.name);
+        QJsonObject entry = previousBenchmarks[name].toObject();
+        entry["medianMs"] = result.medianMs;
+        entry["minMs"] = result.minMs;
+        benchmarks[name] = entry;
+    }
+
+    QJsonObject baseline;
+    baseline["study"] = QString::fromStdString(spec.name);
+    baseline["allocationProfiling"] = AllocationProfiler::enabled();
+    baseline["repetitions"] = repetitions;
+    baseline["benchmarks"] = benchmarks;
+    return writeJson(path, baseline);
+}
+
+// Tolerances applied when a baseline entry does not override them
+struct Tolerances {
+    double time = 0.25;   // Relative slowdown of the median
+    double timeSlackMs = 1.0; // Absolute slack so sub-millisecond benchmarks do not fail on noise
+    double allocations = 0.02; // Relative growth of allocation count and bytes
+};
+
+// Outcome of comparing the results with one baseline file
+struct Comparison {
+    int regressions = 0;
+    int missing = 0; // Benchmarks without an entry in the baseline
+};
+
+// Prints one line per benchmark comparing allocation counts and bytes
+Comparison compareAllocations(const QJsonObject& baseline, const std::vector<BenchmarkResult>& results,
+                              const Tolerances& defaults) {
+    QJsonObject benchmarks = baseline["benchmarks"].toObject();
+    Comparison comparison;
+
+    std::printf("%-26s %14s %14s %14s %14s  %s\n", "benchmark", "allocations", "baseline", "bytes", "baseline", "status");
+    for (const auto& result : results) {
+        QJsonObject entry = benchmarks[QString::fromStdString(result.name)].toObject();
+        if (!entry.contains("allocations") || !entry.contains("bytes")) {
+            std::printf("%-26s %14llu %14s %14llu %14s  NO BASELINE\n", result.name.c_str(),
+                        static_cast<unsigned long long>(result.allocations), "-",
+                        static_cast<unsigned long long>(result.bytes), "-");
+            ++comparison.missing;
+            continue;
+        }
+
+        double tolerance = entry.value("allocTolerance").toDouble(defaults.allocations);
+        double baseAllocations = entry["allocations"].toDouble();
+        double baseBytes = entry["bytes"].toDouble();
+
+        const char* status = "ok";
+        if (result.allocations > baseAllocations * (1.0 + tolerance) || result.bytes > baseBytes * (1.0 + tolerance)) {
+            status = "MORE ALLOCATIONS";
+            ++comparison.regressions;
+        } else if (result.allocations < baseAllocations * (1.0 - tolerance)) {
+            // Recording the improvement keeps it from being lost again unnoticed
+            status = "ok (fewer, consider updating the baseline)";
+        }
+
+        std::printf("%-26s %14llu %14.0f %14llu %14.0f  %s\n", result.name.c_str(),
+                    static_cast<unsigned long long>(result.allocations), baseAllocations,
+                    static_cast<unsigned long long>(result.bytes), baseBytes, status);
+    }
+    return comparison;
+}
+
+// Prints one line per benchmark comparing median times, benchmarks without a time are not checked
+Comparison compareTimes(const QJsonObject& baseline, const std::vector<BenchmarkResult>& results,
+                        const Tolerances& defaults) {
+    QJsonObject benchmarks = baseline["benchmarks"].toObject();
+    Comparison comparison;
+
+    std::printf("%-26s %12s %12s  %s\n", "benchmark", "median ms", "baseline", "status");
+    for (const auto& result : results) {
+        QJsonObject entry = benchmarks[QString::fromStdString(result.name)].toObject();
+        if (!entry.contains("medianMs")) {
+            std::printf("%-26s %12.3f %12s  no baseline\n", result.name.c_str(), result.medianMs, "-");
+            ++comparison.missing;
+            continue;
+        }
+
+        double tolerance = entry.value("timeTolerance").toDouble(defaults.time);
+        double baseMs = entry["medianMs"].toDouble();
+
+        const char* status = "ok";
+        if (result.medianMs > baseMs * (1.0 + tolerance) + defaults.timeSlackMs) {
+            status = "SLOWER";
+            ++comparison.regressions;
+        } else if (result.medianMs < baseMs * (1.0 - tolerance)) {
+            status = "ok (faster, consider updating the baseline)";
+        }
+
+        std::printf("%-26s %12.3f %12.3f  %s\n", result.name.c_str(), result.medianMs, baseMs, status);
+    }
+    return comparison;
+}
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("DicomViewerPerf");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Performance regression suite for the DICOM viewer");
+    parser.addHelpOption();
+    parser.addOption({"study", "Synthetic study to run: small, medium or large.", "name", "small"});
+    parser.addOption({"baseline", "Allocation baseline JSON file to compare with or update.", "file"});
+    parser.addOption({"timing-baseline", "Machine local JSON file with times to compare with or update, recorded on first use.", "file"});
+    parser.addOption({"work-dir", "Directory for the generated studies.", "dir",
+                      QDir::temp().filePath("dicomviewer-perf")});
+    parser.addOption({"repetitions", "Timed runs per benchmark, the median is compared.", "n", "5"});
+    parser.addOption({"time-tolerance", "Allowed relative slowdown of the median time.", "fraction", "0.25"});
+    parser.addOption({"time-slack-ms", "Allowed absolute slowdown in milliseconds.", "ms", "1.0"});
+    parser.addOption({"alloc-tolerance", "Allowed relative growth in allocations and bytes.", "fraction", "0.02"});
+    parser.addOption({"update-baseline", "Record this run as the new baselines instead of comparing."});
+    parser.process(app);
+
+    SyntheticStudySpec spec;
+    if (!findSyntheticStudy(parser.value("study").toStdString(), spec)) {
+        std::cerr << "Error: Unknown study " << parser.value("study").toStdString() << std::endl;
+        return kSetupErrorReturnCode;
+    }
+    QString baselinePath = parser.value("baseline");
+    if (baselinePath.isEmpty()) {
+        std::cerr << "Error: --baseline is required." << std::endl;
+        return kSetupErrorReturnCode;
+    }
+    QString timingPath = parser.value("timing-baseline");
+    int repetitions = std::max(1, parser.value("repetitions").toInt());
+    Tolerances tolerances;
+    tolerances.time = parser.value("time-tolerance").toDouble();
+    tolerances.timeSlackMs = parser.value("time-slack-ms").toDouble();
+    tolerances.allocations = parser.value("alloc-tolerance").toDouble();
+
+    std::string studyPath = QDir(parser.value("work-dir")).filePath(QString::fromStdString(spec.name)).toStdString();
+    if (!generateSyntheticStudy(spec, studyPath)) {
+        return kSetupErrorReturnCode;
+    }
+    if (!AllocationProfiler::enabled()) {
+        std::cout << "Note: built without DICOMVIEWER_ALLOC_PROFILING, allocations are not checked." << std::endl;
+    }
+
+    std::vector<BenchmarkResult> results;
+    if (!runBenchmarks(spec, studyPath, repetitions, results)) {
+        return kSetupErrorReturnCode;
+    }
+
+    if (parser.isSet("update-baseline")) {
+        if (AllocationProfiler::enabled()) {
+            if (!writeAllocationBaseline(baselinePath, spec, results)) {
+                return kSetupErrorReturnCode;
+            }
+            std::cout << "Allocation baseline written to " << baselinePath.toStdString() << std::endl;
+        } else {
+            std::cout << "Allocation baseline left unchanged, record it with DICOMVIEWER_ALLOC_PROFILING=ON." << std::endl;
+        }
+        if (!timingPath.isEmpty()) {
+            if (!writeTimingBaseline(timingPath, spec, repetitions, results)) {
+                return kSetupErrorReturnCode;
+            }
+            std::cout << "Timing baseline written to " << timingPath.toStdString() << std::endl;
+        }
+        return 0;
+    }
+
+    int failures = 0;
+    bool compared = false;
+
+    // Allocation counts are the hard gate: a profiling build must have a matching committed baseline
+    if (AllocationProfiler::enabled()) {
+        QJsonObject baseline;
+        if (!readJson(baselinePath, baseline)) {
+            std::cout << "Error: No allocation baseline at " << baselinePath.toStdString()
+                      << ", record one with --update-baseline (or the perf_update_baselines target)." << std::endl;
+            compareAllocations(QJsonObject(), results, tolerances);
+            return kRegressionReturnCode;
+        }
+        if (!baseline["allocationProfiling"].toBool() || baseline["study"].toString() != QString::fromStdString(spec.name)) {
+            std::cout << "Error: " << baselinePath.toStdString() << " is not an allocation baseline for study "
+                      << spec.name << ", re-record it with DICOMVIEWER_ALLOC_PROFILING=ON." << std::endl;
+            return kRegressionReturnCode;
+        }
+
+        Comparison allocations = compareAllocations(baseline, results, tolerances);
+        if (allocations.missing > 0) {
+            std::cout << allocations.missing << " benchmark(s) have no allocation baseline in "
+                      << baselinePath.toStdString() << std::endl;
+        }
+        failures += allocations.regressions + allocations.missing;
+        compared = true;
+    }
+
+    // Times depend on the machine, so they are compared with a local baseline. The first run of a
+    // build records it, every later run of that build is checked against it.
+    QJsonObject timing;
+    std::string skipReason;
+    if (timingPath.isEmpty()) {
+        skipReason = "no --timing-baseline given, times are not checked";
+    } else if (!readJson(timingPath, timing) ||
+               timing["allocationProfiling"].toBool() != AllocationProfiler::enabled()) {
+        // The counting allocator slows every path down, times are only comparable within one configuration
+        if (!writeTimingBaseline(timingPath, spec, repetitions, results)) {
+            return kSetupErrorReturnCode;
+        }
+        skipReason = "recorded the timing baseline " + timingPath.toStdString() + ", later runs are checked against it";
+    } else {
+        failures += compareTimes(timing, results, tolerances).regressions;
+        compared = true;
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " benchmark(s) failed against the baselines." << std::endl;
+        return kRegressionReturnCode;
+    }
+    if (!compared) {
+        // Printed last so it is the line CTest shows next to the skipped test
+        std::cout << "SKIPPED: " << skipReason << std::endl;
+        return kSkipReturnCode;
+    }
+    if (!skipReason.empty()) {
+        std::cout << "Note: " << skipReason << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "SyntheticStudy.h"
+
+#include "cnpy.h"
+
+// DCMTK Headers
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kPixelSpacing = 1.5;    // mm, typical short axis cine resolution
+constexpr double kSliceSpacing = 8.0;    // mm between series
+const char* const kMarkerFile = "study.txt";
+
+// Text identifying a spec, written once a study is complete
+std::string describe(const SyntheticStudySpec& spec) {
+    std::ostringstream out;
+    out << "synthetic study v1 " << spec.name << ' ' << spec.seriesCount << ' ' << spec.timepoints << ' '
+        << spec.rows << ' ' << spec.cols << ' ' << spec.contourPoints;
+    return out.str();
+}
+
+// Blood pool radius in pixels, one contraction over the timepoints like a cardiac cycle
+double bloodPoolRadius(const SyntheticStudySpec& spec, int series, int timepoint) {
+    double base = 0.22 * std::min(spec.rows, spec.cols);
+    double taper = 1.0 - 0.4 * series / std::max(1, spec.seriesCount); // Smaller towards the apex
+    double contraction = 1.0 - 0.3 * std::sin(kPi * timepoint / std::max(1, spec.timepoints));
+    return base * taper * contraction;
+}
+
+// Writes one frame, pixel values are a bright disc inside a darker ring on a gradient background
+bool writeFrame(const SyntheticStudySpec& spec, int series, int timepoint, const fs::path& path) {
+    double centerX = 0.5 * spec.cols;
+    double centerY = 0.5 * spec.rows;
+    double radius = bloodPoolRadius(spec, series, timepoint);
+
+    std::vector<Uint16> pixels(static_cast<size_t>(spec.rows) * spec.cols);
+    for (int row = 0; row < spec.rows; ++row) {
+        for (int col = 0; col < spec.cols; ++col) {
+            double distance = std::hypot(col - centerX, row - centerY);
+            Uint16 value = static_cast<Uint16>(100 + (row * 200) / spec.rows);
+            if (distance < radius) {
+                value = 1200;
+            } else if (distance < radius + 4.0) {
+                value = 400;
+            }
+            pixels[static_cast<size_t>(row) * spec.cols + col] = value;
+        }
+    }
+
+    // Fixed UIDs below the DCMTK site root keep the files byte for byte reproducible
+    std::ostringstream uid;
+    uid << SITE_INSTANCE_UID_ROOT << ".9." << spec.rows << '.' << series << '.' << timepoint;
+    char position[96];
+    std::snprintf(position, sizeof(position), "%.1f\\%.1f\\%.1f",
+                  -0.5 * spec.cols * kPixelSpacing, -0.5 * spec.rows * kPixelSpacing, series * kSliceSpacing);
+    char spacing[48];
+    std::snprintf(spacing, sizeof(spacing), "%.2f\\%.2f", kPixelSpacing, kPixelSpacing);
+
+    DcmFileFormat fileformat;
+    DcmDataset* dataset = fileformat.getDataset();
+    dataset->putAndInsertString(DCM_SOPClassUID, UID_MRImageStorage);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, uid.str().c_str());
+    dataset->putAndInsertString(DCM_Modality, "MR");
+    dataset->putAndInsertString(DCM_PatientName, "Perf^Synthetic");
+    dataset->putAndInsertString(DCM_ImagePositionPatient, position);
+    dataset->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+    dataset->putAndInsertString(DCM_PixelSpacing, spacing);
+    dataset->putAndInsertString(DCM_InstanceNumber, std::to_string(timepoint + 1).c_str());
+    dataset->putAndInsertString(DCM_RescaleSlope, "1");
+    dataset->putAndInsertString(DCM_RescaleIntercept, "0");
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+    dataset->putAndInsertUint16(DCM_Rows, static_cast<Uint16>(spec.rows));
+    dataset->putAndInsertUint16(DCM_Columns, static_cast<Uint16>(spec.cols));
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset->putAndInsertUint16(DCM_BitsStored, 12);
+    dataset->putAndInsertUint16(DCM_HighBit, 11);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), pixels.size());
+
+    OFCondition status = fileformat.saveFile(path.string().c_str(), EXS_LittleEndianExplicit);
+    if (status.bad()) {
+        std::cerr << "Error: Cannot write " << path.string() << ": " << status.text() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Writes the contour next to a frame as a (2, N) array, x coordinates first
+void writeContour(const SyntheticStudySpec& spec, int series, int timepoint, const fs::path& path) {
+    double radius = bloodPoolRadius(spec, series, timepoint);
+    size_t n = static_cast<size_t>(spec.contourPoints);
+    std::vector<double> points(2 * n);
+    for (size_t i = 0; i < n; ++i) {
+        double angle = 2.0 * kPi * i / n;
+        points[i] = 0.5 * spec.cols + radius * std::cos(angle);
+        points[n + i] = 0.5 * spec.rows + radius * std::sin(angle);
+    }
+    cnpy::npy_save(path.string(), points.data(), {2, n}, "w");
+}
+}
+
+bool findSyntheticStudy(const std::string& name, SyntheticStudySpec& spec) {
+    const SyntheticStudySpec studies[] = {
+        {"small", 4, 10, 64, 64, 32},
+        {"medium", 10, 25, 128, 128, 64},
+        {"large", 14, 30, 256, 256, 128},
+    };
+    for (const auto& study : studies) {
+        if (study.name == name) {
+            spec = study;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool generateSyntheticStudy(const SyntheticStudySpec& spec, const std::string& rootPath) {
+    fs::path root(rootPath);
+    fs::path marker = root / kMarkerFile;
+
+    // Reuse a complete study with the same spec, the marker is written last
+    {
+        std::ifstream in(marker);
+        std::string existing;
+        if (in && std::getline(in, existing) && existing == describe(spec)) {
+            return true;
+        }
+    }
+
+    std::error_code error;
+    fs::remove_all(root, error);
+    for (int series = 0; series < spec.seriesCount; ++series) {
+        char seriesName[32];
+        std::snprintf(seriesName, sizeof(seriesName), "sa_%02d", series);
+        fs::path seriesPath = root / seriesName;
+        if (!fs::create_directories(seriesPath, error) && error) {
+            std::cerr << "Error: Cannot create " << seriesPath.string() << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        for (int timepoint = 0; timepoint < spec.timepoints; ++timepoint) {
+            char frameName[32];
+            std::snprintf(frameName, sizeof(frameName), "frame_%03d", timepoint);
+            if (!writeFrame(spec, series, timepoint, seriesPath / (std::string(frameName) + ".dcm"))) {
+                return false;
+            }
+            writeContour(spec, series, timepoint, seriesPath / (std::string(frameName) + "_cont.npy"));
+        }
+    }
+
+    std::ofstream out(marker);
+    out << describe(spec) << '\n';
+    return static_cast<bool>(out);
+}
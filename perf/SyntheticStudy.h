@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// Shape of a generated study. Every series is one short axis slice position with one file per
+// timepoint, laid out like the real data: <root>/<series>/<frame>.dcm plus <frame>_cont.npy.
+struct SyntheticStudySpec {
+    std::string name;       // Also the directory name below the work directory
+    int seriesCount = 1;    // Slice positions
+    int timepoints = 1;     // Files per series
+    int rows = 64;
+    int cols = 64;
+    int contourPoints = 32; // Points per contour file
+};
+
+// The fixed studies the perf suite runs on, looked up by name ("small", "medium", "large")
+bool findSyntheticStudy(const std::string& name, SyntheticStudySpec& spec);
+
+// Writes the study below rootPath unless an identical one is already there. The content only
+// depends on the spec, so repeated runs and different machines measure the same data.
+bool generateSyntheticStudy(const SyntheticStudySpec& spec, const std::string& rootPath);
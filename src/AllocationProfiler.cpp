@@ -0,0 +1,222 @@
+#include "AllocationProfiler.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+namespace {
+constexpr int kPhaseCount = static_cast<int>(AllocPhase::Count);
+
+// Plain atomics only, anything that allocates would recurse into operator new
+struct PhaseCounters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> peakBytes{0};
+    std::atomic<uint64_t> entries{0};
+};
+
+PhaseCounters g_phases[kPhaseCount];
+thread_local int t_currentPhase = 0; // Constant initialised, safe to touch inside operator new
+std::atomic<uint64_t> g_liveBytes{0};
+std::atomic<uint64_t> g_peakBytes{0};
+
+// Raises an atomic maximum
+void updateMax(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t previous = target.load(std::memory_order_relaxed);
+    while (value > previous && !target.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+}
+
+const char* const kPhaseNames[kPhaseCount] = {
+    "other", "discover", "parse", "decode", "contour", "scene_build", "render"
+};
+}
+
+#ifdef DICOMVIEWER_ALLOC_PROFILING
+namespace {
+// Every block carries its size in a header in front of the returned pointer
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+void recordAllocation(size_t size) {
+    PhaseCounters& phase = g_phases[t_currentPhase];
+    phase.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.bytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t live = g_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    updateMax(g_peakBytes, live);
+    updateMax(phase.peakBytes, live);
+}
+
+void recordFree(size_t size) {
+    g_phases[t_currentPhase].frees.fetch_add(1, std::memory_order_relaxed);
+    g_liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void* countedAlloc(size_t size, size_t alignment) {
+    // The header occupies a full alignment unit so the user pointer keeps the requested alignment
+    size_t offset = alignment > kHeaderSize ? alignment : kHeaderSize;
+    void* base = nullptr;
+    if (alignment > kHeaderSize) {
+        if (posix_memalign(&base, alignment, size + offset) != 0) base = nullptr;
+    } else {
+        base = std::malloc(size + offset);
+    }
+    if (!base) return nullptr;
+
+    char* user = static_cast<char*>(base) + offset;
+    reinterpret_cast<size_t*>(user)[-1] = size;
+    recordAllocation(size);
+    return user;
+}
+
+void countedFree(void* ptr, size_t alignment) {
+    if (!ptr) return;
+    size_t offset = alignment > kHeaderSize ? alignment : kHeaderSize;
+    recordFree(reinterpret_cast<size_t*>(ptr)[-1]);
+    std::free(static_cast<char*>(ptr) - offset);
+}
+
+void* countedAllocOrThrow(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* ptr = countedAlloc(size, alignment)) return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+}
+
+// Replacement allocation functions, all forms funnel into countedAlloc/countedFree
+void* operator new(size_t size) { return countedAllocOrThrow(size, kHeaderSize); }
+void* operator new[](size_t size) { return countedAllocOrThrow(size, kHeaderSize); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size ? size : 1, kHeaderSize); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size ? size : 1, kHeaderSize); }
+void* operator new(size_t size, std::align_val_t align) { return countedAllocOrThrow(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return countedAllocOrThrow(size, static_cast<size_t>(align)); }
+
+void operator delete(void* ptr) noexcept { countedFree(ptr, kHeaderSize); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr, kHeaderSize); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr, kHeaderSize); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr, kHeaderSize); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr, kHeaderSize); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr, kHeaderSize); }
+void operator delete(void* ptr, std::align_val_t align) noexcept { countedFree(ptr, static_cast<size_t>(align)); }
+void operator delete[](void* ptr, std::align_val_t align) noexcept { countedFree(ptr, static_cast<size_t>(align)); }
+void operator delete(void* ptr, size_t, std::align_val_t align) noexcept { countedFree(ptr, static_cast<size_t>(align)); }
+void operator delete[](void* ptr, size_t, std::align_val_t align) noexcept { countedFree(ptr, static_cast<size_t>(align)); }
+#endif
+
+namespace AllocationProfiler {
+
+bool enabled() {
+#ifdef DICOMVIEWER_ALLOC_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* phaseName(AllocPhase phase) {
+    int index = static_cast<int>(phase);
+    return index >= 0 && index < kPhaseCount ? kPhaseNames[index] : "unknown";
+}
+
+AllocPhaseStats stats(AllocPhase phase) {
+    AllocPhaseStats result;
+    int index = static_cast<int>(phase);
+    if (index < 0 || index >= kPhaseCount) return result;
+    const PhaseCounters& counters = g_phases[index];
+    result.allocations = counters.allocations.load();
+    result.frees = counters.frees.load();
+    result.bytes = counters.bytes.load();
+    result.peakBytes = counters.peakBytes.load();
+    result.entries = counters.entries.load();
+    return result;
+}
+
+uint64_t currentBytes() { return g_liveBytes.load(); }
+uint64_t peakBytes() { return g_peakBytes.load(); }
+
+void reset() {
+    for (auto& phase : g_phases) {
+        phase.allocations = 0;
+        phase.frees = 0;
+        phase.bytes = 0;
+        phase.peakBytes = 0;
+        phase.entries = 0;
+    }
+    g_peakBytes = g_liveBytes.load();
+}
+
+Snapshot snapshot() {
+    Snapshot result;
+    for (int i = 0; i < kPhaseCount; ++i) {
+        result.phases[i] = stats(static_cast<AllocPhase>(i));
+    }
+    result.currentBytes = currentBytes();
+    result.peakBytes = peakBytes();
+    return result;
+}
+
+std::string toJson() {
+    return toJson(snapshot());
+}
+
+std::string toJson(const Snapshot& snapshot) {
+    std::ostringstream out;
+    out << "{\"enabled\":" << (enabled() ? "true" : "false")
+        << ",\"currentBytes\":" << snapshot.currentBytes
+        << ",\"peakBytes\":" << snapshot.peakBytes
+        << ",\"phases\":{";
+    for (int i = 0; i < kPhaseCount; ++i) {
+        const AllocPhaseStats& s = snapshot.phases[i];
+        out << (i ? "," : "") << '"' << kPhaseNames[i] << "\":{"
+            << "\"allocations\":" << s.allocations
+            << ",\"frees\":" << s.frees
+            << ",\"bytes\":" << s.bytes
+            << ",\"peakBytes\":" << s.peakBytes
+            << ",\"entries\":" << s.entries << '}';
+    }
+    out << "}}";
+    return out.str();
+}
+
+std::string summary() {
+    return summary(snapshot());
+}
+
+std::string summary(const Snapshot& snapshot) {
+    if (!enabled()) {
+        return "Allocation profiling not compiled in (DICOMVIEWER_ALLOC_PROFILING=OFF)";
+    }
+
+    char line[128];
+    std::string text = "phase           allocs        MB   peak MB\n";
+    for (int i = 0; i < kPhaseCount; ++i) {
+        const AllocPhaseStats& s = snapshot.phases[i];
+        std::snprintf(line, sizeof(line), "%-12s %9llu %9.2f %9.2f\n", kPhaseNames[i],
+                      static_cast<unsigned long long>(s.allocations), s.bytes / 1048576.0, s.peakBytes / 1048576.0);
+        text += line;
+    }
+    std::snprintf(line, sizeof(line), "live %.2f MB, peak %.2f MB", snapshot.currentBytes / 1048576.0,
+                  snapshot.peakBytes / 1048576.0);
+    text += line;
+    return text;
+}
+
+PhaseScope::PhaseScope(AllocPhase phase)
+    : m_previous(static_cast<AllocPhase>(t_currentPhase))
+{
+    t_currentPhase = static_cast<int>(phase);
+    g_phases[static_cast<int>(phase)].entries.fetch_add(1, std::memory_order_relaxed);
+    updateMax(g_phases[static_cast<int>(phase)].peakBytes, g_liveBytes.load(std::memory_order_relaxed));
+}
+
+PhaseScope::~PhaseScope() {
+    t_currentPhase = static_cast<int>(m_previous);
+}
+
+}
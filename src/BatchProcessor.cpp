@@ -0,0 +1,434 @@
+#include "BatchProcessor.h"
+#include "AllocationProfiler.h"
+#include "ContourGeometry.h"
+#include "DicomManager.h"
+#include "WorkStealingScheduler.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+#include <eigen3/Eigen/Dense>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Milliseconds elapsed since start
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Serialises progress lines coming from several workers
+std::mutex g_logMutex;
+
+// Converts a vector of doubles to a JSON array
+QJsonArray toJsonArray(const std::vector<double>& values) {
+    QJsonArray array;
+    for (double value : values) {
+        array.append(value);
+    }
+    return array;
+}
+
+// Converts window/level presets to a JSON array
+QJsonArray toJsonArray(const std::vector<WindowLevelPreset>& presets) {
+    QJsonArray array;
+    for (const auto& preset : presets) {
+        QJsonObject entry;
+        entry["name"] = QString::fromStdString(preset.name);
+        entry["window"] = preset.window;
+        entry["level"] = preset.level;
+        array.append(entry);
+    }
+    return array;
+}
+
+// Writes a JSON object to disk, indented for humans
+bool writeJson(const fs::path& path, const QJsonObject& object) {
+    QFile file(QString::fromStdString(path.string()));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cerr << "Error: Cannot write " << path.string() << std::endl;
+        return false;
+    }
+    QByteArray data = QJsonDocument(object).toJson(QJsonDocument::Indented);
+    if (file.write(data) != data.size() || !file.flush()) {
+        std::cerr << "Error: Cannot write " << path.string() << ": " << file.errorString().toStdString() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Quotes a CSV field when it contains a separator, quote or line break (RFC 4180)
+std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        return value;
+    }
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+// Median gap between slice positions along the slice normal, used as slice thickness for volumes
+double estimateSliceSpacing(const std::map<std::string, DicomSeries>& seriesMap) {
+    if (seriesMap.empty() || seriesMap.begin()->second.empty()) {
+        return 0.0;
+    }
+
+    const DicomFrame& reference = seriesMap.begin()->second.front();
+    Eigen::Vector3d row(reference.imageOrientation[0], reference.imageOrientation[1], reference.imageOrientation[2]);
+    Eigen::Vector3d col(reference.imageOrientation[3], reference.imageOrientation[4], reference.imageOrientation[5]);
+    Eigen::Vector3d normal = row.cross(col);
+
+    std::vector<double> positions;
+    for (const auto& pair : seriesMap) {
+        const DicomFrame& frame = pair.second.front();
+        Eigen::Vector3d pos(frame.imagePosition[0], frame.imagePosition[1], frame.imagePosition[2]);
+        positions.push_back(pos.dot(normal));
+    }
+    std::sort(positions.begin(), positions.end());
+
+    std::vector<double> gaps;
+    for (size_t i = 1; i < positions.size(); ++i) {
+        double gap = positions[i] - positions[i - 1];
+        if (gap > 1e-3) gaps.push_back(gap); // Ignore duplicated slice locations
+    }
+    if (gaps.empty()) {
+        return 0.0;
+    }
+    std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+    return gaps[gaps.size() / 2];
+}
+}
+
+BatchProcessor::BatchProcessor(const BatchOptions& options)
+    : m_options(options)
+{
+}
+
+// Parses the batch command line and runs it
+int BatchProcessor::runFromCommandLine(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless batch processing of patient directories");
+    parser.addHelpOption();
+    parser.addOption({"batch", "Root directory containing one sub-directory per patient.", "root"});
+    parser.addOption({"output", "Directory for per-patient outputs and the run report.", "dir", "batch_output"});
+    parser.addOption({"jobs", "Number of worker threads (0 = all cores).", "n", "0"});
+    parser.process(arguments);
+
+    BatchOptions options;
+    options.rootPath = parser.value("batch").toStdString();
+    options.outputPath = parser.value("output").toStdString();
+    if (options.rootPath.empty()) {
+        std::cerr << "Error: --batch requires a root directory." << std::endl;
+        return 1;
+    }
+    bool jobsValid = false;
+    options.jobs = parser.value("jobs").toUInt(&jobsValid);
+    if (!jobsValid) {
+        std::cerr << "Error: --jobs must be a non-negative integer, got " << parser.value("jobs").toStdString() << std::endl;
+        return 1;
+    }
+    return BatchProcessor(options).run();
+}
+
+// Lists patient directories sorted by number of DICOM files, largest first
+std::vector<PatientResult> BatchProcessor::discoverPatients() const {
+    std::vector<PatientResult> patients;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(m_options.rootPath, ec)) {
+        if (!entry.is_directory()) continue;
+
+        PatientResult patient;
+        patient.name = entry.path().filename().string();
+        patient.path = entry.path().string();
+
+        // Counting files is cheap and a good predictor of load time
+        for (const auto& series : fs::directory_iterator(entry.path(), ec)) {
+            if (!series.is_directory()) continue;
+            for (const auto& file : fs::directory_iterator(series.path(), ec)) {
+                if (file.path().extension() == ".dcm") ++patient.fileCount;
+            }
+        }
+        patients.push_back(patient);
+    }
+
+    std::sort(patients.begin(), patients.end(), [](const PatientResult& a, const PatientResult& b) {
+        return a.fileCount != b.fileCount ? a.fileCount > b.fileCount : a.name < b.name;
+    });
+    return patients;
+}
+
+// Runs all patients through the scheduler and writes the run report
+int BatchProcessor::run() {
+    if (!fs::is_directory(m_options.rootPath)) {
+        std::cerr << "Error: Batch root is not a valid directory: " << m_options.rootPath << std::endl;
+        return 1;
+    }
+    std::error_code ec;
+    fs::create_directories(m_options.outputPath, ec);
+    if (ec) {
+        std::cerr << "Error: Cannot create output directory " << m_options.outputPath << ": " << ec.message() << std::endl;
+        return 1;
+    }
+
+    std::vector<PatientResult> results = discoverPatients();
+    if (results.empty()) {
+        std::cerr << "Error: No patient directories found in " << m_options.rootPath << std::endl;
+        return 1;
+    }
+
+    WorkStealingScheduler scheduler(m_options.jobs);
+    std::cout << "--- Batch processing " << results.size() << " patients on "
+              << scheduler.workerCount() << " workers ---" << std::endl;
+
+    // Every task writes only to its own result slot
+    std::vector<WorkStealingScheduler::Task> tasks;
+    tasks.reserve(results.size());
+    for (auto& result : results) {
+        PatientResult* slot = &result;
+        tasks.push_back([this, slot](unsigned worker) { processPatient(*slot, worker); });
+    }
+
+    Clock::time_point start = Clock::now();
+    scheduler.run(std::move(tasks));
+    double wallSeconds = elapsedMs(start) / 1000.0;
+
+    bool reportWritten = writeRunReport(results, wallSeconds, scheduler.workerCount(), scheduler.stealCount());
+
+    size_t failed = std::count_if(results.begin(), results.end(), [](const PatientResult& r) { return !r.success; });
+    std::cout << "--- Batch finished in " << wallSeconds << " s, " << failed << " failed ---" << std::endl;
+    if (!reportWritten) {
+        return 1;
+    }
+    return failed == 0 ? 0 : 2;
+}
+
+// Loads a single patient, derives contour metrics and writes its outputs
+void BatchProcessor::processPatient(PatientResult& result, unsigned worker) const {
+    Clock::time_point patientStart = Clock::now();
+    result.worker = worker;
+
+    try {
+        DicomManager manager;
+        // Patients already run in parallel, nested parse threads would only oversubscribe the cores
+        manager.setParseThreads(1);
+        manager.setSeriesWindowPresets(true); // Recorded per series in metadata.json
+        Clock::time_point stageStart = Clock::now();
+        std::vector<std::string> seriesNames = manager.discoverSeries(result.path);
+        result.discoverMs = elapsedMs(stageStart);
+        if (seriesNames.empty()) {
+            throw std::runtime_error("no series sub-directories");
+        }
+
+        stageStart = Clock::now();
+        if (!manager.loadSelectedSeries(result.path, seriesNames)) {
+            throw std::runtime_error("no readable DICOM frames");
+        }
+        result.loadMs = elapsedMs(stageStart);
+
+        const auto& seriesMap = manager.getSeries();
+        result.seriesCount = static_cast<int>(seriesMap.size());
+        result.timepointCount = manager.getNumberOfFrames();
+        for (const auto& pair : seriesMap) {
+            result.frameCount += static_cast<int>(pair.second.size());
+        }
+
+        // Contour metrics, one CSV row per contour plus per-timepoint totals
+        stageStart = Clock::now();
+        std::ostringstream csv;
+        csv << "series,timepoint,instance_number,file,points,area_mm2,perimeter_mm\n";
+        std::vector<double> timepointArea(result.timepointCount, 0.0);
+        std::vector<int> timepointContours(result.timepointCount, 0);
+
+        for (const auto& pair : seriesMap) {
+            std::string seriesName = fs::path(pair.first).filename().string();
+            const DicomSeries& series = pair.second;
+            for (size_t t = 0; t < series.size(); ++t) {
+                AllocationProfiler::PhaseScope contourPhase(AllocPhase::Contour);
+                const DicomFrame& frame = series[t];
+                ContourGeometry contour;
+                if (frame.contourFilePath.empty() || !ContourGeometry::loadFromNpy(frame.contourFilePath, contour)) {
+                    continue;
+                }
+                double area = contour.area(frame.pixelSpacing[1], frame.pixelSpacing[0]);
+                double perimeter = contour.perimeter(frame.pixelSpacing[1], frame.pixelSpacing[0]);
+                csv << csvField(seriesName) << ',' << t << ',' << frame.instanceNumber << ','
+                    << csvField(fs::path(frame.contourFilePath).filename().string()) << ','
+                    << contour.size() << ',' << area << ',' << perimeter << '\n';
+                timepointArea[t] += area;
+                ++timepointContours[t];
+                ++result.contourCount;
+            }
+        }
+
+        // Disc summation: contour area times slice spacing, in millilitres
+        double sliceSpacing = estimateSliceSpacing(seriesMap);
+        QJsonArray timepoints;
+        int maxVolumeIndex = -1;
+        int minVolumeIndex = -1;
+        std::vector<double> volumes(result.timepointCount, 0.0);
+        for (int t = 0; t < result.timepointCount; ++t) {
+            volumes[t] = timepointArea[t] * sliceSpacing / 1000.0;
+            QJsonObject entry;
+            entry["timepoint"] = t;
+            entry["contours"] = timepointContours[t];
+            entry["areaMm2"] = timepointArea[t];
+            entry["volumeMl"] = volumes[t];
+            timepoints.append(entry);
+
+            if (timepointContours[t] == 0) continue;
+            if (maxVolumeIndex < 0 || volumes[t] > volumes[maxVolumeIndex]) maxVolumeIndex = t;
+            if (minVolumeIndex < 0 || volumes[t] < volumes[minVolumeIndex]) minVolumeIndex = t;
+        }
+
+        QJsonObject contourSummary;
+        contourSummary["sliceSpacingMm"] = sliceSpacing;
+        contourSummary["contourCount"] = result.contourCount;
+        contourSummary["timepoints"] = timepoints;
+        if (maxVolumeIndex >= 0 && volumes[maxVolumeIndex] > 0.0) {
+            double edv = volumes[maxVolumeIndex];
+            double esv = volumes[minVolumeIndex];
+            contourSummary["endDiastolicTimepoint"] = maxVolumeIndex;
+            contourSummary["endSystolicTimepoint"] = minVolumeIndex;
+            contourSummary["endDiastolicVolumeMl"] = edv;
+            contourSummary["endSystolicVolumeMl"] = esv;
+            contourSummary["ejectionFraction"] = (edv - esv) / edv;
+        }
+        result.contourMs = elapsedMs(stageStart);
+
+        stageStart = Clock::now();
+        writePatientOutputs(result, manager, contourSummary, csv.str());
+        result.writeMs = elapsedMs(stageStart);
+        result.success = true;
+    } catch (const std::exception& e) {
+        // cnpy and the filesystem report problems through exceptions, keep the other patients going
+        result.error = e.what();
+    }
+
+    result.totalMs = elapsedMs(patientStart);
+
+    std::lock_guard<std::mutex> lock(g_logMutex);
+    if (result.success) {
+        std::cout << "[worker " << worker << "] " << result.name << ": " << result.frameCount << " frames, "
+                  << result.contourCount << " contours in " << result.totalMs << " ms" << std::endl;
+    } else {
+        std::cerr << "[worker " << worker << "] " << result.name << " failed: " << result.error << std::endl;
+    }
+}
+
+// Writes the metadata summary and contour metrics of one patient
+void BatchProcessor::writePatientOutputs(const PatientResult& result, const DicomManager& manager,
+                                         const QJsonObject& contourSummary, const std::string& contourCsv) const {
+    fs::path patientDir = fs::path(m_options.outputPath) / result.name;
+    fs::create_directories(patientDir);
+
+    QJsonArray series;
+    for (const auto& pair : manager.getSeries()) {
+        const DicomSeries& frames = pair.second;
+        const DicomFrame& first = frames.front();
+        int contours = static_cast<int>(std::count_if(frames.begin(), frames.end(),
+            [](const DicomFrame& f) { return !f.contourFilePath.empty(); }));
+
+        QJsonObject entry;
+        entry["name"] = QString::fromStdString(fs::path(pair.first).filename().string());
+        entry["frames"] = static_cast<int>(frames.size());
+        entry["rows"] = first.rows;
+        entry["cols"] = first.cols;
+        entry["pixelSpacing"] = toJsonArray(first.pixelSpacing);
+        entry["imagePosition"] = toJsonArray(first.imagePosition);
+        entry["imageOrientation"] = toJsonArray(first.imageOrientation);
+        entry["firstInstanceNumber"] = first.instanceNumber;
+        entry["lastInstanceNumber"] = frames.back().instanceNumber;
+        entry["contourFiles"] = contours;
+        entry["windowPresets"] = toJsonArray(manager.getSeriesWindowPresets(pair.first));
+        series.append(entry);
+    }
+
+    QJsonObject metadata;
+    metadata["patient"] = QString::fromStdString(result.name);
+    metadata["path"] = QString::fromStdString(result.path);
+    metadata["seriesCount"] = result.seriesCount;
+    metadata["frameCount"] = result.frameCount;
+    metadata["timepointCount"] = result.timepointCount;
+    metadata["series"] = series;
+    metadata["windowPresets"] = toJsonArray(manager.getWindowPresets());
+    metadata["contours"] = contourSummary;
+    // Failures throw so processPatient records them in the patient's result
+    if (!writeJson(patientDir / "metadata.json", metadata)) {
+        throw std::runtime_error("cannot write " + (patientDir / "metadata.json").string());
+    }
+
+    fs::path csvPath = patientDir / "contour_metrics.csv";
+    std::ofstream csvFile(csvPath);
+    csvFile << contourCsv;
+    csvFile.close();
+    if (!csvFile) {
+        throw std::runtime_error("cannot write " + csvPath.string());
+    }
+}
+
+// Aggregates all patient results into run_report.json, false if it cannot be written
+bool BatchProcessor::writeRunReport(const std::vector<PatientResult>& results, double wallSeconds,
+                                    unsigned workers, size_t steals) const {
+    QJsonArray patients;
+    int succeeded = 0;
+    long long frames = 0;
+    double busyMs = 0.0;
+    for (const auto& result : results) {
+        QJsonObject entry;
+        entry["patient"] = QString::fromStdString(result.name);
+        entry["success"] = result.success;
+        if (!result.success) entry["error"] = QString::fromStdString(result.error);
+        entry["worker"] = static_cast<int>(result.worker);
+        entry["dicomFiles"] = static_cast<double>(result.fileCount);
+        entry["series"] = result.seriesCount;
+        entry["frames"] = result.frameCount;
+        entry["contours"] = result.contourCount;
+        entry["discoverMs"] = result.discoverMs;
+        entry["loadMs"] = result.loadMs;
+        entry["contourMs"] = result.contourMs;
+        entry["writeMs"] = result.writeMs;
+        entry["totalMs"] = result.totalMs;
+        patients.append(entry);
+
+        if (result.success) ++succeeded;
+        frames += result.frameCount;
+        busyMs += result.totalMs;
+    }
+
+    QJsonObject report;
+    report["root"] = QString::fromStdString(m_options.rootPath);
+    report["workers"] = static_cast<int>(workers);
+    report["steals"] = static_cast<double>(steals);
+    report["patients"] = static_cast<int>(results.size());
+    report["succeeded"] = succeeded;
+    report["failed"] = static_cast<int>(results.size()) - succeeded;
+    report["wallSeconds"] = wallSeconds;
+    report["patientsPerSecond"] = wallSeconds > 0.0 ? results.size() / wallSeconds : 0.0;
+    report["framesPerSecond"] = wallSeconds > 0.0 ? frames / wallSeconds : 0.0;
+    // Share of the worker time spent on patients, low values point at load imbalance
+    report["workerUtilization"] = wallSeconds > 0.0 ? busyMs / (wallSeconds * 1000.0 * workers) : 0.0;
+    report["patientResults"] = patients;
+    // Allocation counts per phase, all zero unless built with DICOMVIEWER_ALLOC_PROFILING
+    report["allocations"] = QJsonDocument::fromJson(QByteArray::fromStdString(AllocationProfiler::toJson())).object();
+    return writeJson(fs::path(m_options.outputPath) / "run_report.json", report);
+}
@@ -0,0 +1,93 @@
+#include "ContourGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Read numpy files
+#include "cnpy.h"
+
+// Recomputes the bounding box of the contour points
+void ContourGeometry::updateBounds() {
+    if (x.empty()) {
+        minX = maxX = minY = maxY = 0.0;
+        return;
+    }
+    auto xRange = std::minmax_element(x.begin(), x.end());
+    auto yRange = std::minmax_element(y.begin(), y.end());
+    minX = *xRange.first;
+    maxX = *xRange.second;
+    minY = *yRange.first;
+    maxY = *yRange.second;
+}
+
+// Crossing number test, each edge flips the state when a ray towards +x crosses it
+bool ContourGeometry::contains(double px, double py) const {
+    if (empty() || px < minX || px > maxX || py < minY || py > maxY) {
+        return false;
+    }
+
+    bool inside = false;
+    size_t n = x.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        if ((y[i] > py) != (y[j] > py)) {
+            double crossX = x[j] + (py - y[j]) * (x[i] - x[j]) / (y[i] - y[j]);
+            if (px < crossX) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+// Shoelace formula over the closed polygon, scaled from pixels to mm
+double ContourGeometry::area(double spacingX, double spacingY) const {
+    if (empty()) {
+        return 0.0;
+    }
+    double twiceArea = 0.0;
+    size_t n = x.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        twiceArea += x[j] * y[i] - x[i] * y[j];
+    }
+    return 0.5 * std::abs(twiceArea) * spacingX * spacingY;
+}
+
+// Sum of edge lengths including the closing edge
+double ContourGeometry::perimeter(double spacingX, double spacingY) const {
+    if (empty()) {
+        return 0.0;
+    }
+    double length = 0.0;
+    size_t n = x.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        length += std::hypot((x[i] - x[j]) * spacingX, (y[i] - y[j]) * spacingY);
+    }
+    return length;
+}
+
+// Loads contour points from a numpy file
+bool ContourGeometry::loadFromNpy(const std::string& path, ContourGeometry& contour) {
+    contour = ContourGeometry();
+    if (path.empty()) {
+        return false;
+    }
+
+    // Validate numpy array shape (should be 2xN)
+    cnpy::NpyArray arr = cnpy::npy_load(path);
+    if (arr.shape.size() != 2 || arr.shape[0] != 2) {
+        std::cerr << "Warning: Contour file " << path
+                  << " has incorrect shape. Expected (2, N).\n";
+        return false;
+    }
+
+    // First row holds x coordinates, second row holds y coordinates
+    const double* data = arr.data<double>();
+    size_t num_points = arr.shape[1];
+    contour.x.assign(data, data + num_points);
+    contour.y.assign(data + num_points, data + 2 * num_points);
+    contour.updateBounds();
+
+    // Need at least 2 points to form a contour
+    return !contour.empty();
+}
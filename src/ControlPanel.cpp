@@ -4,7 +4,10 @@
 #include <QSlider>
 #include <QLabel>
 #include <QCheckBox> 
+#include <QComboBox>
+#include <QStringList>
 #include <QHBoxLayout>
+#include <QSignalBlocker>
 
 // Constructs the control panel with all UI components
 ControlPanel::ControlPanel(QWidget *parent) : QWidget(parent) {
@@ -13,6 +16,16 @@ ControlPanel::ControlPanel(QWidget *parent) : QWidget(parent) {
     m_frameSlider = new QSlider(Qt::Horizontal);
     m_frameLabel = new QLabel("--/--");
     m_transparencyToggle = new QCheckBox("Transparent Slices"); 
+    m_windowPresetBox = new QComboBox();
+    m_windowPresetBox->setEnabled(false); // Filled once a study is loaded
+    m_playButton = new QPushButton("Play");
+    m_playButton->setCheckable(true);
+    m_smoothCineToggle = new QCheckBox("Smooth Cine");
+    m_slowMotionBox = new QComboBox();
+    for (int factor : {1, 2, 4, 8}) {
+        m_slowMotionBox->addItem(QString("%1x slower").arg(factor), factor);
+    }
+    m_slowMotionBox->setItemText(0, "Real time");
 
     // Set Initial State
     setControlsEnabled(false);
@@ -23,11 +36,24 @@ ControlPanel::ControlPanel(QWidget *parent) : QWidget(parent) {
     layout->addWidget(m_loadPatientButton); // Load patient button
     layout->addWidget(m_frameSlider, 1); // Frame slider 
     layout->addWidget(m_frameLabel); // Frame information label
+    layout->addWidget(m_playButton); // Cine playback
+    layout->addWidget(m_smoothCineToggle); // Temporal interpolation toggle
+    layout->addWidget(m_slowMotionBox); // Slow motion factor
     layout->addWidget(m_transparencyToggle); // Transparency toggle checkbox
+    layout->addWidget(m_windowPresetBox); // Window/level preset selection
 
     // Connect signals to slots
     connect(m_loadPatientButton, &QPushButton::clicked, this, &ControlPanel::loadPatientClicked); // Handle load patient button
     connect(m_transparencyToggle, &QCheckBox::toggled, this, &ControlPanel::transparencyToggled);  // Transparency toggle changes
+    connect(m_windowPresetBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ControlPanel::windowPresetChanged); // Preset selection changes
+    connect(m_playButton, &QPushButton::toggled, this, [this](bool playing) {
+        m_playButton->setText(playing ? "Pause" : "Play");
+        emit playToggled(playing);
+    }); // Playback start/stop
+    connect(m_smoothCineToggle, &QCheckBox::toggled, this, &ControlPanel::smoothCineToggled); // Interpolation toggle changes
+    connect(m_slowMotionBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        emit slowMotionChanged(m_slowMotionBox->itemData(index).toInt());
+    }); // Slow motion factor changes
 }
 
 ControlPanel::~ControlPanel() {}
@@ -41,6 +67,9 @@ void ControlPanel::setFrameSliderRange(int min, int max) {
 void ControlPanel::setControlsEnabled(bool enabled) {
     m_frameSlider->setEnabled(enabled);
     m_frameLabel->setEnabled(enabled);
+    m_playButton->setEnabled(enabled);
+    m_smoothCineToggle->setEnabled(enabled);
+    m_slowMotionBox->setEnabled(enabled);
 }
 
 // Updates the frame label to show current position and total frames
@@ -51,4 +80,21 @@ void ControlPanel::updateFrameLabel(int currentFrame, int maxFrame) {
 // Provides access to the frame slider widget
 QSlider* ControlPanel::getFrameSlider() const {
     return m_frameSlider;
-}
\ No newline at end of file
+}
+
+// Fills the preset box with the first preset selected. No windowPresetChanged is emitted, the
+// caller applies the first preset itself.
+void ControlPanel::setWindowPresets(const QStringList& names) {
+    QSignalBlocker blocker(m_windowPresetBox);
+    m_windowPresetBox->clear();
+    m_windowPresetBox->addItems(names);
+    m_windowPresetBox->setCurrentIndex(names.isEmpty() ? -1 : 0);
+    m_windowPresetBox->setEnabled(!names.isEmpty());
+}
+
+// Reflects playback state changes made by the main window, e.g. when a new patient is loaded
+void ControlPanel::setPlaying(bool playing) {
+    QSignalBlocker blocker(m_playButton);
+    m_playButton->setChecked(playing);
+    m_playButton->setText(playing ? "Pause" : "Play");
+}
@@ -1,17 +1,31 @@
 #include "DicomManager.h"
+#include "AllocationProfiler.h"
 
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 // DCMTK Headers
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcdatset.h"
 #include "dcmtk/dcmdata/dcdeftag.h"
 #include "dcmtk/dcmdata/dcostrmz.h"
+#include "dcmtk/dcmimgle/dcmimage.h"
+#include "dcmtk/dcmimgle/dipixel.h"
 
 namespace fs = std::filesystem;
 
+namespace {
+// Widens decoded pixel values of any integer representation to float
+template <typename T>
+void convertPixels(const void* data, size_t count, float* pixels) {
+    const T* values = static_cast<const T*>(data);
+    std::copy(values, values + count, pixels);
+}
+}
+
 // Constructor and Destructor
 DicomManager::DicomManager() {}
 DicomManager::~DicomManager() {}
@@ -19,10 +33,13 @@ DicomManager::~DicomManager() {}
 //
 void DicomManager::clear() {
     m_seriesMap.clear();
+    m_seriesPresets.clear();
+    m_windowPresets.clear();
 }
 
 // Discovers all potential DICOM series in a patient directory
 std::vector<std::string> DicomManager::discoverSeries(const std::string& patientPath) {
+    AllocationProfiler::PhaseScope discoverPhase(AllocPhase::Discover);
     std::vector<std::string> seriesNames;
     if (!fs::exists(patientPath) || !fs::is_directory(patientPath)) {
         std::cerr << "Error: Patient path is not a valid directory: " << patientPath << std::endl;
@@ -41,84 +58,220 @@ std::vector<std::string> DicomManager::discoverSeries(const std::string& patient
 
 // Loads DICOM data from selected series directories
 bool DicomManager::loadSelectedSeries(const std::string& patientPath, const std::vector<std::string>& seriesNames) {
+    AllocationProfiler::PhaseScope parsePhase(AllocPhase::Parse);
     clear(); // Clear previous data before loading new data
 
+    // Gather every candidate file first so the parse work can be split evenly across threads
+    std::vector<std::string> seriesPaths;
+    std::vector<std::pair<size_t, std::string>> files; // (series index, file path)
     for (const auto& name : seriesNames) {
         // Reconstruct the full path to the series directory
         fs::path seriesPath = fs::path(patientPath) / name;
         if (!fs::is_directory(seriesPath)) continue;
 
-        DicomSeries currentSeries;
-        
         // Loop through the files in this series directory
         for (const auto& fileEntry : fs::directory_iterator(seriesPath.string())) {
             if (!fileEntry.is_regular_file() || fileEntry.path().extension() != ".dcm") {
                 continue; // Skip non-DICOM files
             }
+            files.emplace_back(seriesPaths.size(), fileEntry.path().string());
+        }
+        seriesPaths.push_back(seriesPath.string());
+    }
 
-            std::string filePath = fileEntry.path().string();
-            DcmFileFormat fileformat;
-
-            if (fileformat.loadFile(filePath.c_str()).good()) {
-                DcmDataset *dataset = fileformat.getDataset();
-                DicomFrame frame; // Initialize dicom frame
-                frame.filePath = filePath; // Set filepath
-
-                // Extract essential tags
-                OFString value;
-                bool success = true;
-
-                if (dataset->findAndGetOFStringArray(DCM_ImagePositionPatient, value).good()) {
-                    // (X, Y, Z) coordinates of paitient origin
-                    sscanf(value.c_str(), "%lf\\%lf\\%lf", &frame.imagePosition[0], &frame.imagePosition[1], &frame.imagePosition[2]);
-                } else { success = false; }
-                
-                if (dataset->findAndGetOFStringArray(DCM_ImageOrientationPatient, value).good()) {
-                    // First three are left to right cosines, and next 3 are up and down cosines
-                    sscanf(value.c_str(), "%lf\\%lf\\%lf\\%lf\\%lf\\%lf", &frame.imageOrientation[0], &frame.imageOrientation[1], &frame.imageOrientation[2], &frame.imageOrientation[3], &frame.imageOrientation[4], &frame.imageOrientation[5]);
-                } else { success = false; }
-
-                if (dataset->findAndGetOFStringArray(DCM_PixelSpacing, value).good()) {
-                    // Gets pixel spacing values as (y,x)
-                    sscanf(value.c_str(), "%lf\\%lf", &frame.pixelSpacing[0], &frame.pixelSpacing[1]);
-                } else { success = false; }
-                
-                // Temporal position in series
-                Sint32 instNum = 0;
-                if (!dataset->findAndGetSint32(DCM_InstanceNumber, instNum).good()) { success = false; }
-                frame.instanceNumber = instNum;
-                
-                // Extract Image Dimensions
-                Uint16 rows, cols;
-                if (!dataset->findAndGetUint16(DCM_Rows, rows).good()) { success = false; }
-                if (!dataset->findAndGetUint16(DCM_Columns, cols).good()) { success = false; }
-                frame.rows = rows;
-                frame.cols = cols;
-
-                // Only add the frame if all essential tags were found
-                if (success) {
-                    // Find corresponding contour file
-                    fs::path dcmPath(filePath);
-                    std::string contourName = dcmPath.stem().string() + "_cont.npy";
-                    fs::path contourPath = dcmPath.parent_path() / contourName;
-                    if (fs::exists(contourPath)) {
-                        frame.contourFilePath = contourPath.string();
-                    }
-                    currentSeries.push_back(frame);
-                }
-            }
+    // Parse files in parallel. Each worker keeps its own histogram per series, so the
+    // pixel pass needs no locking, and the histograms are merged once all files are done.
+    std::vector<DicomFrame> frames(files.size());
+    std::vector<char> valid(files.size(), 0);
+    std::vector<PixelInfo> pixelInfos(files.size());
+    unsigned threadCount = m_parseThreads ? m_parseThreads : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, std::max<size_t>(1, files.size())));
+    std::vector<std::vector<IntensityHistogram>> localHistograms(threadCount,
+        std::vector<IntensityHistogram>(seriesPaths.size()));
+
+    std::atomic<size_t> nextFile{0};
+    auto worker = [&](unsigned thread) {
+        AllocationProfiler::PhaseScope workerPhase(AllocPhase::Parse);
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+            IntensityHistogram& histogram = localHistograms[thread][files[i].first];
+            valid[i] = parseFile(files[i].second, frames[i], pixelInfos[i], histogram);
+        }
+    };
+    if (threadCount == 1) {
+        worker(0);
+    } else {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.emplace_back(worker, t);
         }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Assemble the series in their original order
+    std::vector<DicomSeries> seriesFrames(seriesPaths.size());
+    std::vector<PixelInfo> seriesPixelInfo(seriesPaths.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!valid[i]) continue;
+        seriesFrames[files[i].first].push_back(std::move(frames[i]));
+        seriesPixelInfo[files[i].first] = pixelInfos[i];
+    }
 
+    // Merge the per-thread histograms, per series and for the whole study
+    IntensityHistogram studyHistogram;
+    int studyBits = 1;
+    bool studySigned = false;
+    for (const auto& info : seriesPixelInfo) {
+        studyBits = std::max(studyBits, info.bitsStored);
+        studySigned = studySigned || info.isSigned;
+    }
+    studyHistogram.reset(studyBits, studySigned);
+
+    for (size_t s = 0; s < seriesPaths.size(); ++s) {
         // Store series if any valid frames were found
-        if (!currentSeries.empty()) {
-            std::sort(currentSeries.begin(), currentSeries.end());
-            m_seriesMap[seriesPath.string()] = currentSeries;
+        if (seriesFrames[s].empty()) continue;
+        std::sort(seriesFrames[s].begin(), seriesFrames[s].end());
+        m_seriesMap[seriesPaths[s]] = std::move(seriesFrames[s]);
+
+        IntensityHistogram seriesHistogram;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            seriesHistogram.merge(localHistograms[t][s]);
+        }
+        if (m_seriesWindowPresets) {
+            m_seriesPresets[seriesPaths[s]] = createWindowPresets(seriesHistogram);
         }
+        studyHistogram.merge(seriesHistogram);
     }
 
+    m_windowPresets = createWindowPresets(studyHistogram);
+
     return !m_seriesMap.empty();
 }
 
+// Parses the header of one file and counts its stored pixel values
+bool DicomManager::parseFile(const std::string& filePath, DicomFrame& frame, PixelInfo& pixelInfo,
+                             IntensityHistogram& histogram) {
+    // Load every element, Pixel Data included, in this one sequential read. With the default
+    // maxReadLength large values stay on disk and the histogram would read the file a second time.
+    DcmFileFormat fileformat;
+    if (!fileformat.loadFile(filePath.c_str(), EXS_Unknown, EGL_noChange, OFstatic_cast(Uint32, -1)).good()) {
+        return false;
+    }
+
+    DcmDataset *dataset = fileformat.getDataset();
+    frame.filePath = filePath; // Set filepath
+
+    // Extract essential tags
+    OFString value;
+    bool success = true;
+
+    if (dataset->findAndGetOFStringArray(DCM_ImagePositionPatient, value).good()) {
+        // (X, Y, Z) coordinates of paitient origin
+        sscanf(value.c_str(), "%lf\\%lf\\%lf", &frame.imagePosition[0], &frame.imagePosition[1], &frame.imagePosition[2]);
+    } else { success = false; }
+    
+    if (dataset->findAndGetOFStringArray(DCM_ImageOrientationPatient, value).good()) {
+        // First three are left to right cosines, and next 3 are up and down cosines
+        sscanf(value.c_str(), "%lf\\%lf\\%lf\\%lf\\%lf\\%lf", &frame.imageOrientation[0], &frame.imageOrientation[1], &frame.imageOrientation[2], &frame.imageOrientation[3], &frame.imageOrientation[4], &frame.imageOrientation[5]);
+    } else { success = false; }
+
+    if (dataset->findAndGetOFStringArray(DCM_PixelSpacing, value).good()) {
+        // Gets pixel spacing values as (y,x)
+        sscanf(value.c_str(), "%lf\\%lf", &frame.pixelSpacing[0], &frame.pixelSpacing[1]);
+    } else { success = false; }
+    
+    // Temporal position in series
+    Sint32 instNum = 0;
+    if (!dataset->findAndGetSint32(DCM_InstanceNumber, instNum).good()) { success = false; }
+    frame.instanceNumber = instNum;
+    
+    // Extract Image Dimensions
+    Uint16 rows, cols;
+    if (!dataset->findAndGetUint16(DCM_Rows, rows).good()) { success = false; }
+    if (!dataset->findAndGetUint16(DCM_Columns, cols).good()) { success = false; }
+    frame.rows = rows;
+    frame.cols = cols;
+
+    // Only add the frame if all essential tags were found
+    if (!success) {
+        return false;
+    }
+
+    // Find corresponding contour file
+    fs::path dcmPath(filePath);
+    std::string contourName = dcmPath.stem().string() + "_cont.npy";
+    fs::path contourPath = dcmPath.parent_path() / contourName;
+    if (fs::exists(contourPath)) {
+        frame.contourFilePath = contourPath.string();
+    }
+
+    // Pixel Data came in with the header, so the histogram is one pass over memory and no extra
+    // file read. Compressed pixel data cannot be read this way and simply contributes no counts.
+    Uint16 bitsAllocated = 16, bitsStored = 16, highBit = 15, pixelRepresentation = 0;
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    dataset->findAndGetUint16(DCM_BitsStored, bitsStored);
+    if (!dataset->findAndGetUint16(DCM_HighBit, highBit).good()) {
+        highBit = bitsStored - 1;
+    }
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation);
+
+    pixelInfo.bitsStored = bitsStored;
+    pixelInfo.isSigned = pixelRepresentation == 1;
+    if (histogram.total() == 0 && histogram.bitsStored() == 0) {
+        histogram.reset(bitsStored, pixelInfo.isSigned);
+    }
+
+    size_t pixelCount = static_cast<size_t>(rows) * cols;
+    if (bitsAllocated == 16) {
+        const Uint16* pixels = nullptr;
+        unsigned long count = 0;
+        if (dataset->findAndGetUint16Array(DCM_PixelData, pixels, &count).good() && pixels) {
+            // Strips bits above Bits Stored and sign extends signed data from High Bit
+            histogram.addStored(pixels, std::min<unsigned long>(count, pixelCount), highBit);
+        }
+    } else if (bitsAllocated == 8) {
+        const Uint8* pixels = nullptr;
+        unsigned long count = 0;
+        if (dataset->findAndGetUint8Array(DCM_PixelData, pixels, &count).good() && pixels) {
+            histogram.add(pixels, std::min<unsigned long>(count, pixelCount));
+        }
+    }
+    return true;
+}
+
+// Turns a histogram into percentile based window/level presets. The slices are shown straight
+// from vtkDICOMImageReader, which does not apply the modality rescale, so the presets stay in
+// stored values as well.
+std::vector<WindowLevelPreset> DicomManager::createWindowPresets(const IntensityHistogram& histogram) {
+    // Without pixel statistics keep the historic fixed window
+    if (histogram.empty()) {
+        return { WindowLevelPreset{"Default", 1000.0, 500.0} };
+    }
+
+    struct Range { const char* name; double low; double high; };
+    const Range ranges[] = {
+        {"Auto (1-99%)", 0.01, 0.99},
+        {"Narrow (5-95%)", 0.05, 0.95},
+        {"Wide (0.5-99.5%)", 0.005, 0.995},
+        {"Full range", 0.0, 1.0},
+    };
+
+    std::vector<WindowLevelPreset> presets;
+    for (const auto& range : ranges) {
+        double low = histogram.percentile(range.low);
+        double high = histogram.percentile(range.high);
+        if (high < low) std::swap(low, high);
+
+        WindowLevelPreset preset;
+        preset.name = range.name;
+        preset.window = std::max(1.0, high - low);
+        preset.level = 0.5 * (low + high);
+        presets.push_back(preset);
+    }
+    return presets;
+}
+
 // Retrieves frames from all series at a specific time index
 std::vector<DicomFrame> DicomManager::getFramesForTimepoint(int timeIndex) const {
     std::vector<DicomFrame> frames;
@@ -149,4 +302,58 @@ int DicomManager::getNumberOfFrames() const {
         }
     }
     return static_cast<int>(maxFrames);
-}
\ No newline at end of file
+}
+
+// Read only access to the loaded series
+const std::map<std::string, DicomSeries>& DicomManager::getSeries() const {
+    return m_seriesMap;
+}
+
+// Decodes the pixel data of a single frame through DCMTK's image pipeline
+bool DicomManager::decodeFrame(const DicomFrame& frame, float* pixels) {
+    AllocationProfiler::PhaseScope decodePhase(AllocPhase::Decode);
+    DicomImage image(frame.filePath.c_str());
+    if (image.getStatus() != EIS_Normal) {
+        std::cerr << "Error: Cannot decode " << frame.filePath << ": "
+                  << DicomImage::getString(image.getStatus()) << std::endl;
+        return false;
+    }
+
+    // Intermediate data holds the modality values (rescale slope and intercept applied)
+    const DiPixel* inter = image.getInterData();
+    size_t count = static_cast<size_t>(frame.rows) * frame.cols;
+    if (!inter || image.getWidth() != static_cast<unsigned long>(frame.cols) ||
+        image.getHeight() != static_cast<unsigned long>(frame.rows) || inter->getCount() < count) {
+        std::cerr << "Error: Unexpected pixel layout in " << frame.filePath << std::endl;
+        return false;
+    }
+
+    const void* data = inter->getData();
+    switch (inter->getRepresentation()) {
+        case EPR_Uint8:  convertPixels<Uint8>(data, count, pixels); break;
+        case EPR_Sint8:  convertPixels<Sint8>(data, count, pixels); break;
+        case EPR_Uint16: convertPixels<Uint16>(data, count, pixels); break;
+        case EPR_Sint16: convertPixels<Sint16>(data, count, pixels); break;
+        case EPR_Uint32: convertPixels<Uint32>(data, count, pixels); break;
+        case EPR_Sint32: convertPixels<Sint32>(data, count, pixels); break;
+        default: return false;
+    }
+    return true;
+}
+
+const std::vector<WindowLevelPreset>& DicomManager::getWindowPresets() const {
+    return m_windowPresets;
+}
+
+void DicomManager::setSeriesWindowPresets(bool enabled) {
+    m_seriesWindowPresets = enabled;
+}
+
+std::vector<WindowLevelPreset> DicomManager::getSeriesWindowPresets(const std::string& seriesPath) const {
+    auto it = m_seriesPresets.find(seriesPath);
+    return it != m_seriesPresets.end() ? it->second : std::vector<WindowLevelPreset>();
+}
+
+void DicomManager::setParseThreads(unsigned threads) {
+    m_parseThreads = threads;
+}
@@ -0,0 +1,121 @@
+#include "IntensityHistogram.h"
+
+#include <algorithm>
+
+// Allocates zeroed bins covering the full value range of the stored bits
+void IntensityHistogram::reset(int bitsStored, bool isSigned) {
+    m_bitsStored = std::max(1, std::min(16, bitsStored));
+    m_signed = isSigned;
+    size_t bins = size_t(1) << m_bitsStored;
+    m_offset = m_signed ? -static_cast<int>(bins / 2) : 0;
+    m_counts.assign(bins, 0);
+    m_total = 0;
+}
+
+// Maps a value to its bin, clamping values outside the stored range
+size_t IntensityHistogram::valueBin(int value) const {
+    int bin = value - m_offset;
+    if (bin < 0) return 0;
+    if (bin >= static_cast<int>(m_counts.size())) return m_counts.size() - 1;
+    return static_cast<size_t>(bin);
+}
+
+void IntensityHistogram::add(const uint8_t* values, size_t count) {
+    if (m_counts.empty()) reset(8, false);
+    for (size_t i = 0; i < count; ++i) {
+        ++m_counts[valueBin(values[i])];
+    }
+    m_total += count;
+}
+
+void IntensityHistogram::add(const uint16_t* values, size_t count) {
+    if (m_counts.empty()) reset(16, false);
+    // Fast path for the common case: unsigned data, bins indexed by the value itself
+    if (!m_signed) {
+        size_t last = m_counts.size() - 1;
+        for (size_t i = 0; i < count; ++i) {
+            ++m_counts[std::min<size_t>(values[i], last)];
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            ++m_counts[valueBin(values[i])];
+        }
+    }
+    m_total += count;
+}
+
+void IntensityHistogram::add(const int16_t* values, size_t count) {
+    if (m_counts.empty()) reset(16, true);
+    for (size_t i = 0; i < count; ++i) {
+        ++m_counts[valueBin(values[i])];
+    }
+    m_total += count;
+}
+
+void IntensityHistogram::addStored(const uint16_t* cells, size_t count, int highBit) {
+    if (m_counts.empty()) reset(16, false);
+    int shift = std::max(0, std::min(16 - m_bitsStored, highBit + 1 - m_bitsStored));
+    if (shift == 0 && m_bitsStored == 16) {
+        // Nothing to strip, the cells are the values
+        if (m_signed) {
+            add(reinterpret_cast<const int16_t*>(cells), count);
+        } else {
+            add(cells, count);
+        }
+        return;
+    }
+
+    // Every extracted value fits the bins exactly, no clamping needed
+    const unsigned mask = (1u << m_bitsStored) - 1u;
+    if (m_signed) {
+        const int signBit = 1 << (m_bitsStored - 1);
+        for (size_t i = 0; i < count; ++i) {
+            int value = static_cast<int>((cells[i] >> shift) & mask);
+            value = (value ^ signBit) - signBit;
+            ++m_counts[static_cast<size_t>(value - m_offset)];
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            ++m_counts[(cells[i] >> shift) & mask];
+        }
+    }
+    m_total += count;
+}
+
+// Adds another histogram bin by bin, re-binning when the layouts differ
+void IntensityHistogram::merge(const IntensityHistogram& other) {
+    if (other.empty()) return;
+    if (m_counts.empty()) {
+        *this = other;
+        return;
+    }
+
+    if (other.m_offset == m_offset && other.m_counts.size() == m_counts.size()) {
+        for (size_t bin = 0; bin < m_counts.size(); ++bin) {
+            m_counts[bin] += other.m_counts[bin];
+        }
+    } else {
+        for (size_t bin = 0; bin < other.m_counts.size(); ++bin) {
+            if (other.m_counts[bin] != 0) {
+                m_counts[valueBin(other.binValue(bin))] += other.m_counts[bin];
+            }
+        }
+    }
+    m_total += other.m_total;
+}
+
+// Walks the cumulative distribution up to the requested fraction
+double IntensityHistogram::percentile(double fraction) const {
+    if (empty()) return 0.0;
+
+    fraction = std::max(0.0, std::min(1.0, fraction));
+    uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(m_total));
+    uint64_t cumulative = 0;
+    for (size_t bin = 0; bin < m_counts.size(); ++bin) {
+        cumulative += m_counts[bin];
+        if (cumulative > 0 && cumulative >= target) {
+            return binValue(bin);
+        }
+    }
+    return binValue(m_counts.size() - 1);
+}
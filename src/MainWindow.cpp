@@ -1,15 +1,30 @@
 #include "MainWindow.h"
 #include "ControlPanel.h"
 #include "SeriesSelectionDialog.h"
+#include "VolumeServer.h"
+#include "AllocationProfiler.h"
 
 #include <QVTKOpenGLNativeWidget.h>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <QFileDialog>
 #include <QSlider>
+#include <QStatusBar>
+#include <QMouseEvent>
+#include <QStringList>
+#include <QFile>
+#include <QTimer>
+#include <QSignalBlocker>
 #include <vtkRenderWindow.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+namespace {
+constexpr int kCineIntervalMs = 33;        // About 30 displayed frames per second
+constexpr double kCineCycleSeconds = 1.0;  // Real time duration of one pass over all timepoints
+}
+
 // Construct main application
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     // Set window properties
@@ -25,6 +40,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     // Create and add the visualization and control components
     m_vtkWidget = new QVTKOpenGLNativeWidget();
     m_controlPanel = new ControlPanel();
+    m_cineTimer = new QTimer(this);
+    m_cineTimer->setInterval(kCineIntervalMs);
 
     // Add widgets to layout 
     mainLayout->addWidget(m_vtkWidget, 1);
@@ -33,6 +50,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     // Initialize VTK manager and connect signals to slots
     m_vtkManager.setup(m_vtkWidget);
     setupConnections();
+
+    // Hover readout, mouse tracking delivers move events without a pressed button
+    m_vtkWidget->setMouseTracking(true);
+    m_vtkWidget->installEventFilter(this);
+    statusBar()->showMessage("No data loaded");
 }
 
 // Destructor  
@@ -48,7 +70,25 @@ void MainWindow::setupConnections() {
     connect(slider, &QSlider::sliderReleased, this, &MainWindow::onSliderReleased);
     // Connect transparency toggle signal
     connect(m_controlPanel, &ControlPanel::transparencyToggled, this, &MainWindow::onTransparencyToggled);
+    // Connect window/level preset selection
+    connect(m_controlPanel, &ControlPanel::windowPresetChanged, this, &MainWindow::onWindowPresetChanged);
+    // Cine playback controls
+    connect(m_controlPanel, &ControlPanel::playToggled, this, &MainWindow::onPlayToggled);
+    connect(m_controlPanel, &ControlPanel::smoothCineToggled, this, [this](bool smooth) { m_smoothCine = smooth; });
+    connect(m_controlPanel, &ControlPanel::slowMotionChanged, this, [this](int factor) { m_slowMotion = std::max(1, factor); });
+    connect(m_cineTimer, &QTimer::timeout, this, &MainWindow::onCineTick);
+}
 
+// Creates the volume server and routes contours written by clients into the scene
+bool MainWindow::startVolumeServer(const QString& name) {
+    if (!m_volumeServer) {
+        m_volumeServer = new VolumeServer(m_dicomManager, this);
+        connect(m_volumeServer, &VolumeServer::contourWritten, this,
+                [this](const QString& filePath, const ContourGeometry& contour) {
+                    m_vtkManager.overrideContour(filePath.toStdString(), contour);
+                });
+    }
+    return m_volumeServer->listen(name);
 }
 
 // Handles the "Load Patient" button click event
@@ -61,6 +101,9 @@ void MainWindow::onLoadPatient() {
         return;
     }
 
+    // The allocation report covers this load, from discovery to the first rendered frame
+    AllocationProfiler::reset();
+
     // Discover available DICOM series in the selected directory
     std::vector<std::string> seriesNames = m_dicomManager.discoverSeries(patientPath.toStdString());
 
@@ -69,22 +112,49 @@ void MainWindow::onLoadPatient() {
         return;
     }
 
-    // Show series selection dialog to the user
-    SeriesSelectionDialog dialog(seriesNames, this);
-    if (dialog.exec() == QDialog::Accepted) {
-        std::vector<std::string> selectedSeries = dialog.getSelectedSeries();
+    // Show series selection dialog to the user. Waiting for the user and generating thumbnails
+    // are not part of the load, so they are counted as other work
+    std::vector<std::string> selectedSeries;
+    bool accepted = false;
+    {
+        AllocationProfiler::PhaseScope dialogPhase(AllocPhase::Other);
+        SeriesSelectionDialog dialog(patientPath.toStdString(), seriesNames, this);
+        accepted = dialog.exec() == QDialog::Accepted;
+        if (accepted) {
+            selectedSeries = dialog.getSelectedSeries();
+        }
+    }
+    if (accepted) {
         if (selectedSeries.empty()) {
             std::cout << "User did not select any series." << std::endl;
             return;
         }
 
         std::cout << "--- Loading " << selectedSeries.size() << " selected series... ---" << std::endl;
+
+        // Playback belongs to the previous study
+        stopPlayback();
+
+        // Anything published or written back for the previous study no longer applies
+        if (m_volumeServer) {
+            m_volumeServer->studyChanged();
+        }
+        m_vtkManager.clearContourOverrides();
+        m_timepointFrames.clear();
         
         // Load the selected DICOM series
         if (m_dicomManager.loadSelectedSeries(patientPath.toStdString(), selectedSeries)) {
             // Get the number of frames in the longest series
             int numFrames = m_dicomManager.getNumberOfFrames();
 
+            // Offer the presets computed while loading and apply the first one
+            QStringList presetNames;
+            for (const auto& preset : m_dicomManager.getWindowPresets()) {
+                presetNames << QString::fromStdString(preset.name);
+            }
+            m_controlPanel->setWindowPresets(presetNames);
+            onWindowPresetChanged(0);
+
             if (numFrames > 1) {
                 // Enable controls and set slider range, assuming multiple frames
                 m_controlPanel->setFrameSliderRange(0, numFrames - 1);
@@ -100,8 +170,9 @@ void MainWindow::onLoadPatient() {
             }
             
             // Update the visualization and reset camera view
-            onSliderReleased(); // Load and display the first frame
+            showTimepoint(m_controlPanel->getFrameSlider()->value()); // Load and display the first frame
             m_vtkManager.resetCamera(); // Adjust camera to fit all objects
+            updateAllocationReport();
 
         } else {
             std::cout << "Failed to load DICOM data from the selected series." << std::endl;
@@ -120,15 +191,130 @@ void MainWindow::onSliderMoved(int frameIndex) {
 
 // Handles frame slider release events
 void MainWindow::onSliderReleased() {
-    int frameIndex = m_controlPanel->getFrameSlider()->value();
+    // The report covers this frame change only
+    AllocationProfiler::reset();
+    showTimepoint(m_controlPanel->getFrameSlider()->value());
+    updateAllocationReport();
+}
+
+// Shows all slices of a timepoint
+void MainWindow::showTimepoint(int frameIndex) {
     std::cout << "Updating scene to frame " << frameIndex << std::endl;
+    // Playback continues from wherever the slider was dropped
+    m_cinePosition = frameIndex;
+    m_cineDisplayedFrame = frameIndex;
+    m_cinePair = {-1, -1};
 
     // Get all frames for the selected timepoint and update visualization
-    std::vector<DicomFrame> frames = m_dicomManager.getFramesForTimepoint(frameIndex);
-    m_vtkManager.createScene(frames);
+    m_vtkManager.createScene(timepointFrames(frameIndex));
 
     // Trigger rendering of the updated scene
+    {
+        AllocationProfiler::PhaseScope renderPhase(AllocPhase::Render);
+        m_vtkWidget->renderWindow()->Render();
+    }
+}
+
+// Slices of a timepoint, gathered and sorted once per loaded study
+const std::vector<DicomFrame>& MainWindow::timepointFrames(int frameIndex) {
+    if (m_timepointFrames.empty()) {
+        int numFrames = m_dicomManager.getNumberOfFrames();
+        m_timepointFrames.reserve(numFrames);
+        for (int t = 0; t < numFrames; ++t) {
+            m_timepointFrames.push_back(m_dicomManager.getFramesForTimepoint(t));
+        }
+    }
+    static const std::vector<DicomFrame> kNoFrames;
+    return frameIndex >= 0 && frameIndex < static_cast<int>(m_timepointFrames.size())
+        ? m_timepointFrames[frameIndex] : kNoFrames;
+}
+
+// Starts playback from the current slider position
+void MainWindow::onPlayToggled(bool playing) {
+    if (!playing) {
+        stopPlayback();
+        return;
+    }
+    if (m_dicomManager.getNumberOfFrames() < 2) {
+        m_controlPanel->setPlaying(false);
+        return;
+    }
+    m_cinePosition = m_controlPanel->getFrameSlider()->value();
+    m_cineDisplayedFrame = -1;
+    m_cineTimer->start();
+}
+
+// Stops playback, the scene keeps showing the last displayed frame
+void MainWindow::stopPlayback() {
+    m_cineTimer->stop();
+    m_controlPanel->setPlaying(false);
+}
+
+// Advances the cine position. In smooth mode every tick shows a frame interpolated between the
+// two neighbouring timepoints (the last one blends back into the first, a cardiac cycle loops),
+// otherwise the scene is only rebuilt when the position reaches the next timepoint.
+void MainWindow::onCineTick() {
+    int numFrames = m_dicomManager.getNumberOfFrames();
+    if (numFrames < 2) {
+        stopPlayback();
+        return;
+    }
+
+    double step = numFrames * (kCineIntervalMs / 1000.0) / (kCineCycleSeconds * m_slowMotion);
+    m_cinePosition = std::fmod(m_cinePosition + step, static_cast<double>(numFrames));
+    int frameIndex = static_cast<int>(m_cinePosition);
+
+    if (m_smoothCine) {
+        // Actors are only rebuilt when the pair changes, the other ticks just run the blend kernels
+        std::pair<int, int> pair(frameIndex, (frameIndex + 1) % numFrames);
+        if (pair != m_cinePair) {
+            m_vtkManager.setInterpolatedFrames(timepointFrames(pair.first), timepointFrames(pair.second));
+            m_cinePair = pair;
+        }
+        m_vtkManager.setInterpolationAlpha(m_cinePosition - frameIndex);
+        m_cineDisplayedFrame = -1;
+    } else if (frameIndex != m_cineDisplayedFrame) {
+        m_vtkManager.createScene(timepointFrames(frameIndex));
+        m_cineDisplayedFrame = frameIndex;
+        m_cinePair = {-1, -1};
+    } else {
+        return;
+    }
+
+    // Follow along on the slider, valueChanged keeps the frame label current
+    m_controlPanel->getFrameSlider()->setValue(frameIndex);
+    {
+        AllocationProfiler::PhaseScope renderPhase(AllocPhase::Render);
+        m_vtkWidget->renderWindow()->Render();
+    }
+}
+
+// Starts reporting allocation statistics in the overlay and as JSON after each load and frame change
+void MainWindow::enableAllocationReport(const QString& jsonPath) {
+    m_allocationReportPath = jsonPath;
+    if (!AllocationProfiler::enabled()) {
+        std::cout << "Warning: built without DICOMVIEWER_ALLOC_PROFILING, allocation counts stay zero." << std::endl;
+    }
+    updateAllocationReport();
+}
+
+// Refreshes the overlay and rewrites the JSON report
+void MainWindow::updateAllocationReport() {
+    if (m_allocationReportPath.isEmpty()) {
+        return;
+    }
+    // One snapshot feeds both outputs, the render that shows the overlay is not part of them
+    AllocationProfiler::Snapshot snapshot = AllocationProfiler::snapshot();
+    m_vtkManager.setDebugOverlayText(AllocationProfiler::summary(snapshot));
     m_vtkWidget->renderWindow()->Render();
+
+    QFile file(m_allocationReportPath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QByteArray::fromStdString(AllocationProfiler::toJson(snapshot)));
+        file.write("\n");
+    } else {
+        std::cerr << "Error: Cannot write allocation report " << m_allocationReportPath.toStdString() << std::endl;
+    }
 }
 
 // Handles transparency toggle events
@@ -140,4 +326,45 @@ void MainWindow::onTransparencyToggled(bool isTransparent) {
         // The user wants transparency off
         m_vtkManager.setSliceOpacity(1.0); // Set to fully opaque
     }
-}
\ No newline at end of file
+}
+
+// Handles window/level preset selection
+void MainWindow::onWindowPresetChanged(int index) {
+    const auto& presets = m_dicomManager.getWindowPresets();
+    if (index >= 0 && index < static_cast<int>(presets.size())) {
+        m_vtkManager.setWindowLevel(presets[index].window, presets[index].level);
+    }
+}
+
+// Observes mouse moves on the VTK widget, the event still reaches the VTK interactor
+bool MainWindow::eventFilter(QObject* watched, QEvent* event) {
+    if (watched == m_vtkWidget && event->type() == QEvent::MouseMove) {
+        updateProbeReadout(static_cast<QMouseEvent*>(event)->pos());
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+// Probes the scene under the cursor and reports it in the status bar
+void MainWindow::updateProbeReadout(const QPoint& widgetPos) {
+    // VTK display coordinates are in device pixels with the origin at the bottom left
+    double ratio = m_vtkWidget->devicePixelRatioF();
+    double displayX = widgetPos.x() * ratio;
+    double displayY = (m_vtkWidget->height() - widgetPos.y() - 1) * ratio;
+
+    ProbeResult result;
+    if (!m_vtkManager.probe(displayX, displayY, result)) {
+        statusBar()->clearMessage();
+        return;
+    }
+
+    QString contourText = result.hasContour ? (result.insideContour ? "inside" : "outside") : "none";
+    statusBar()->showMessage(QString("World (%1, %2, %3) mm | Slice %4 | Pixel (%5, %6) | Value %7 | Contour: %8")
+        .arg(result.world[0], 0, 'f', 1)
+        .arg(result.world[1], 0, 'f', 1)
+        .arg(result.world[2], 0, 'f', 1)
+        .arg(result.sliceIndex)
+        .arg(result.pixelI)
+        .arg(result.pixelJ)
+        .arg(result.intensity)
+        .arg(contourText));
+}
@@ -1,12 +1,20 @@
 #include "SeriesSelectionDialog.h"
+#include "ThumbnailLoader.h"
 
 #include <QListWidget>
 #include <QListWidgetItem>
 #include <QDialogButtonBox>
 #include <QVBoxLayout>
+#include <QIcon>
+#include <QPixmap>
+#include <filesystem>
+
+namespace {
+constexpr int kThumbnailSize = 96; // Longest side of a series preview, in pixels
+}
 
 // Constructs a series selection dialog
-SeriesSelectionDialog::SeriesSelectionDialog(const std::vector<std::string>& seriesNames, QWidget *parent)
+SeriesSelectionDialog::SeriesSelectionDialog(const std::string& patientPath, const std::vector<std::string>& seriesNames, QWidget *parent)
     : QDialog(parent) // Initialize base QDialog class
 {
     // Set dialog window properties
@@ -16,7 +24,14 @@ SeriesSelectionDialog::SeriesSelectionDialog(const std::vector<std::string>& ser
     
     // Create UI widgets
     m_listWidget = new QListWidget();
+    m_listWidget->setIconSize(QSize(kThumbnailSize, kThumbnailSize));
     m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    m_thumbnailLoader = new ThumbnailLoader(kThumbnailSize, this);
+
+    // Blank placeholder so rows keep their height until the thumbnail arrives
+    QPixmap placeholder(kThumbnailSize, kThumbnailSize);
+    placeholder.fill(Qt::darkGray);
+    QIcon placeholderIcon(placeholder);
 
     // Populate the list with series names
     for (const auto& name : seriesNames) {
@@ -28,6 +43,7 @@ SeriesSelectionDialog::SeriesSelectionDialog(const std::vector<std::string>& ser
         
         // Check it by default for convenience
         item->setCheckState(Qt::Checked);
+        item->setIcon(placeholderIcon);
     }
 
     // Set up the dialog layout
@@ -38,9 +54,27 @@ SeriesSelectionDialog::SeriesSelectionDialog(const std::vector<std::string>& ser
     // Connect button signals to dialog slots
     connect(m_buttonBox, &QDialogButtonBox::accepted, this, &SeriesSelectionDialog::accept);
     connect(m_buttonBox, &QDialogButtonBox::rejected, this, &SeriesSelectionDialog::reject);
+
+    // Thumbnails fill in as they finish, the dialog itself opens immediately
+    connect(m_thumbnailLoader, &ThumbnailLoader::thumbnailReady, this, &SeriesSelectionDialog::onThumbnailReady);
+    for (size_t i = 0; i < seriesNames.size(); ++i) {
+        std::filesystem::path seriesPath = std::filesystem::path(patientPath) / seriesNames[i];
+        m_thumbnailLoader->request(static_cast<int>(i), seriesPath.string());
+    }
 }
 
-SeriesSelectionDialog::~SeriesSelectionDialog() {}
+// Stop the loader before the list widget goes away
+SeriesSelectionDialog::~SeriesSelectionDialog() {
+    m_thumbnailLoader->cancel();
+}
+
+// Replaces the placeholder of a row with its decoded thumbnail
+void SeriesSelectionDialog::onThumbnailReady(int row, const QImage& image) {
+    QListWidgetItem* item = m_listWidget->item(row);
+    if (item) {
+        item->setIcon(QIcon(QPixmap::fromImage(image)));
+    }
+}
 
 // Retrieves the names of all selected series
 std::vector<std::string> SeriesSelectionDialog::getSelectedSeries() const {
@@ -0,0 +1,60 @@
+#include "SharedMemoryRegion.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+// POSIX shared memory
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    release();
+}
+
+// Creates, sizes and maps a shared memory object
+bool SharedMemoryRegion::create(const std::string& name, size_t size) {
+    release();
+    if (size == 0) {
+        return false;
+    }
+
+    // O_EXCL so we never hand out a stale object left behind by a crashed viewer
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        std::cerr << "Error: shm_open(" << name << ") failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Error: Cannot size shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (data == MAP_FAILED) {
+        std::cerr << "Error: Cannot map shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name = name;
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+// Unmaps and unlinks the object if one is held
+void SharedMemoryRegion::release() {
+    if (m_data) {
+        munmap(m_data, m_size);
+        shm_unlink(m_name.c_str());
+    }
+    m_name.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
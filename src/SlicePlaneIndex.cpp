@@ -0,0 +1,244 @@
+#include "SlicePlaneIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr int kLeafSize = 2;            // Planes per leaf, stacks are small so leaves stay tiny
+constexpr double kBoxPadding = 1e-3;    // Inflates flat boxes so axis aligned slices still have volume
+constexpr double kParallelEpsilon = 1e-9;
+
+// Slab test between a ray and an axis aligned box
+bool rayHitsBox(const double boxMin[3], const double boxMax[3], const Eigen::Vector3d& origin,
+                const Eigen::Vector3d& invDirection, double maxT) {
+    double tMin = 0.0;
+    double tMax = maxT;
+    for (int axis = 0; axis < 3; ++axis) {
+        double t0 = (boxMin[axis] - origin[axis]) * invDirection[axis];
+        double t1 = (boxMax[axis] - origin[axis]) * invDirection[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if (tMin > tMax) return false;
+    }
+    return true;
+}
+
+// Squared distance between a point and an axis aligned box
+double boxDistanceSquared(const double boxMin[3], const double boxMax[3], const Eigen::Vector3d& point) {
+    double distance = 0.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        double d = std::max({boxMin[axis] - point[axis], 0.0, point[axis] - boxMax[axis]});
+        distance += d * d;
+    }
+    return distance;
+}
+}
+
+// Clears the previous hierarchy and builds a new one
+void SlicePlaneIndex::build(const std::vector<SlicePlane>& planes) {
+    clear();
+    if (planes.empty()) {
+        return;
+    }
+
+    m_planes = planes;
+    std::vector<Eigen::Vector3d> centroids;
+    centroids.reserve(m_planes.size());
+    for (const auto& plane : m_planes) {
+        double u = 0.5 * (plane.minU + plane.maxU);
+        double v = 0.5 * (plane.minV + plane.maxV);
+        centroids.push_back(plane.origin + u * plane.row + v * plane.col);
+    }
+
+    // A binary tree has at most 2n - 1 nodes
+    m_nodes.reserve(2 * m_planes.size());
+    buildNode(0, static_cast<int>(m_planes.size()), centroids);
+}
+
+void SlicePlaneIndex::clear() {
+    m_planes.clear();
+    m_nodes.clear();
+}
+
+// Builds one node and its children, returns the node index
+int SlicePlaneIndex::buildNode(int first, int count, std::vector<Eigen::Vector3d>& centroids) {
+    int nodeIndex = static_cast<int>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    // Bounds of all rectangles under this node, and of their centroids for choosing the split axis
+    Node node;
+    Eigen::Vector3d centroidMin = centroids[first];
+    Eigen::Vector3d centroidMax = centroids[first];
+    planeBounds(m_planes[first], node.boxMin, node.boxMax);
+    for (int i = first + 1; i < first + count; ++i) {
+        double boxMin[3], boxMax[3];
+        planeBounds(m_planes[i], boxMin, boxMax);
+        for (int axis = 0; axis < 3; ++axis) {
+            node.boxMin[axis] = std::min(node.boxMin[axis], boxMin[axis]);
+            node.boxMax[axis] = std::max(node.boxMax[axis], boxMax[axis]);
+        }
+        centroidMin = centroidMin.cwiseMin(centroids[i]);
+        centroidMax = centroidMax.cwiseMax(centroids[i]);
+    }
+
+    if (count <= kLeafSize) {
+        node.first = first;
+        node.count = count;
+        m_nodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    // Median split along the axis with the largest centroid spread
+    int axis = 0;
+    (centroidMax - centroidMin).maxCoeff(&axis);
+    int middle = first + count / 2;
+
+    // Sort planes and centroids together through an index permutation
+    std::vector<int> order(count);
+    for (int i = 0; i < count; ++i) order[i] = first + i;
+    std::nth_element(order.begin(), order.begin() + (middle - first), order.end(),
+                     [&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+    std::vector<SlicePlane> sortedPlanes;
+    std::vector<Eigen::Vector3d> sortedCentroids;
+    sortedPlanes.reserve(count);
+    sortedCentroids.reserve(count);
+    for (int i : order) {
+        sortedPlanes.push_back(m_planes[i]);
+        sortedCentroids.push_back(centroids[i]);
+    }
+    std::copy(sortedPlanes.begin(), sortedPlanes.end(), m_planes.begin() + first);
+    std::copy(sortedCentroids.begin(), sortedCentroids.end(), centroids.begin() + first);
+
+    node.left = buildNode(first, middle - first, centroids);
+    node.right = buildNode(middle, first + count - middle, centroids);
+    m_nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+// Bounds of the four corners of a slice rectangle
+void SlicePlaneIndex::planeBounds(const SlicePlane& plane, double boxMin[3], double boxMax[3]) {
+    const double us[2] = {plane.minU, plane.maxU};
+    const double vs[2] = {plane.minV, plane.maxV};
+    for (int axis = 0; axis < 3; ++axis) {
+        boxMin[axis] = std::numeric_limits<double>::max();
+        boxMax[axis] = std::numeric_limits<double>::lowest();
+    }
+    for (double u : us) {
+        for (double v : vs) {
+            Eigen::Vector3d corner = plane.origin + u * plane.row + v * plane.col;
+            for (int axis = 0; axis < 3; ++axis) {
+                boxMin[axis] = std::min(boxMin[axis], corner[axis] - kBoxPadding);
+                boxMax[axis] = std::max(boxMax[axis], corner[axis] + kBoxPadding);
+            }
+        }
+    }
+}
+
+// Ray against a single slice rectangle
+bool SlicePlaneIndex::intersectPlane(const SlicePlane& plane, const Eigen::Vector3d& origin,
+                                     const Eigen::Vector3d& direction, double maxT, SliceHit& hit) {
+    double denom = plane.normal.dot(direction);
+    if (std::abs(denom) < kParallelEpsilon) {
+        return false; // Ray runs along the plane
+    }
+    double t = plane.normal.dot(plane.origin - origin) / denom;
+    if (t < 0.0 || t >= maxT) {
+        return false;
+    }
+
+    // Express the hit point in the slice's own axes and check it lies on the image
+    Eigen::Vector3d point = origin + t * direction;
+    Eigen::Vector3d local = point - plane.origin;
+    double u = local.dot(plane.row);
+    double v = local.dot(plane.col);
+    if (u < plane.minU || u > plane.maxU || v < plane.minV || v > plane.maxV) {
+        return false;
+    }
+
+    hit.sliceIndex = plane.sliceIndex;
+    hit.distance = t;
+    hit.world = point;
+    hit.u = u;
+    hit.v = v;
+    return true;
+}
+
+// Nearest rectangle along a ray, traversing closer children first
+bool SlicePlaneIndex::intersectRay(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, SliceHit& hit) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    // Division by zero gives infinities, which the slab test handles correctly
+    Eigen::Vector3d invDirection = direction.cwiseInverse();
+    double bestT = std::numeric_limits<double>::max();
+    bool found = false;
+
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (!rayHitsBox(node.boxMin, node.boxMax, origin, invDirection, bestT)) {
+            continue;
+        }
+        if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                if (intersectPlane(m_planes[i], origin, direction, bestT, hit)) {
+                    bestT = hit.distance;
+                    found = true;
+                }
+            }
+            continue;
+        }
+        // Median splits keep the depth near log2(n), far below the stack size
+        stack[stackSize++] = node.right;
+        stack[stackSize++] = node.left;
+    }
+    return found;
+}
+
+// Closest rectangle to a point, measured along each plane's normal
+bool SlicePlaneIndex::closestSlice(const Eigen::Vector3d& point, double tolerance, SliceHit& hit) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    double bestDistance = tolerance;
+    bool found = false;
+
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (boxDistanceSquared(node.boxMin, node.boxMax, point) > bestDistance * bestDistance) {
+            continue;
+        }
+        if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const SlicePlane& plane = m_planes[i];
+                Eigen::Vector3d local = point - plane.origin;
+                double distance = std::abs(local.dot(plane.normal));
+                double u = local.dot(plane.row);
+                double v = local.dot(plane.col);
+                if (distance <= bestDistance &&
+                    u >= plane.minU && u <= plane.maxU && v >= plane.minV && v <= plane.maxV) {
+                    bestDistance = distance;
+                    hit.sliceIndex = plane.sliceIndex;
+                    hit.distance = distance;
+                    hit.world = point - local.dot(plane.normal) * plane.normal;
+                    hit.u = u;
+                    hit.v = v;
+                    found = true;
+                }
+            }
+            continue;
+        }
+        stack[stackSize++] = node.right;
+        stack[stackSize++] = node.left;
+    }
+    return found;
+}
@@ -0,0 +1,198 @@
+#include "TemporalInterpolation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define DICOMVIEWER_SIMD_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define DICOMVIEWER_SIMD_AVX_DISPATCH 1 // AVX kernels compiled per function, picked at run time
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DICOMVIEWER_SIMD_NEON 1
+#endif
+
+namespace {
+
+#ifdef DICOMVIEWER_SIMD_AVX_DISPATCH
+__attribute__((target("avx"))) size_t blendFloatAvx(const float* a, const float* b, float* out, size_t count, float alpha) {
+    const __m256 w = _mm256_set1_ps(alpha);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 va = _mm256_loadu_ps(a + i);
+        __m256 vb = _mm256_loadu_ps(b + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(w, _mm256_sub_ps(vb, va))));
+    }
+    return i;
+}
+
+__attribute__((target("avx"))) size_t blendDoubleAvx(const double* a, const double* b, double* out, size_t count, double alpha) {
+    const __m256d w = _mm256_set1_pd(alpha);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(va, _mm256_mul_pd(w, _mm256_sub_pd(vb, va))));
+    }
+    return i;
+}
+
+bool cpuHasAvx() {
+    static const bool hasAvx = __builtin_cpu_supports("avx");
+    return hasAvx;
+}
+#endif
+
+// Vector part of the float blend, returns how many elements were done
+size_t blendFloatSimd(const float* a, const float* b, float* out, size_t count, float alpha) {
+#ifdef DICOMVIEWER_SIMD_AVX_DISPATCH
+    if (cpuHasAvx()) return blendFloatAvx(a, b, out, count, alpha);
+#endif
+    size_t i = 0;
+#if defined(DICOMVIEWER_SIMD_SSE2)
+    const __m128 w = _mm_set1_ps(alpha);
+    for (; i + 4 <= count; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(w, _mm_sub_ps(vb, va))));
+    }
+#elif defined(DICOMVIEWER_SIMD_NEON)
+    const float32x4_t w = vdupq_n_f32(alpha);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t va = vld1q_f32(a + i);
+        float32x4_t vb = vld1q_f32(b + i);
+        vst1q_f32(out + i, vmlaq_f32(va, w, vsubq_f32(vb, va)));
+    }
+#endif
+    return i;
+}
+
+// Vector part of the double blend, returns how many elements were done
+size_t blendDoubleSimd(const double* a, const double* b, double* out, size_t count, double alpha) {
+#ifdef DICOMVIEWER_SIMD_AVX_DISPATCH
+    if (cpuHasAvx()) return blendDoubleAvx(a, b, out, count, alpha);
+#endif
+    size_t i = 0;
+#if defined(DICOMVIEWER_SIMD_SSE2)
+    const __m128d w = _mm_set1_pd(alpha);
+    for (; i + 2 <= count; i += 2) {
+        __m128d va = _mm_loadu_pd(a + i);
+        __m128d vb = _mm_loadu_pd(b + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(va, _mm_mul_pd(w, _mm_sub_pd(vb, va))));
+    }
+#else
+    (void)a; (void)b; (void)out; (void)count; (void)alpha;
+#endif
+    return i;
+}
+
+// Signed area in pixel units, positive for counter-clockwise contours
+double signedArea(const ContourGeometry& contour) {
+    double twiceArea = 0.0;
+    size_t n = contour.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        twiceArea += contour.x[j] * contour.y[i] - contour.x[i] * contour.y[j];
+    }
+    return 0.5 * twiceArea;
+}
+}
+
+namespace TemporalInterpolation {
+
+void blendImages(const float* a, const float* b, float* out, size_t count, float alpha) {
+    size_t i = blendFloatSimd(a, b, out, count, alpha);
+    for (; i < count; ++i) {
+        out[i] = a[i] + alpha * (b[i] - a[i]);
+    }
+}
+
+void blendPoints(const double* a, const double* b, double* out, size_t count, double alpha) {
+    size_t i = blendDoubleSimd(a, b, out, count, alpha);
+    for (; i < count; ++i) {
+        out[i] = a[i] + alpha * (b[i] - a[i]);
+    }
+}
+
+// Walks the closed outline and emits a point every perimeter / pointCount
+ContourGeometry resampleContour(const ContourGeometry& contour, size_t pointCount) {
+    ContourGeometry result;
+    size_t n = contour.size();
+    if (n == 0 || pointCount == 0) {
+        return result;
+    }
+
+    // Cumulative arc length at the start of every edge, the last edge closes the loop
+    std::vector<double> arcLength(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        size_t next = (i + 1) % n;
+        arcLength[i + 1] = arcLength[i] + std::hypot(contour.x[next] - contour.x[i], contour.y[next] - contour.y[i]);
+    }
+    double perimeter = arcLength[n];
+
+    result.x.resize(pointCount);
+    result.y.resize(pointCount);
+    if (perimeter <= 0.0) {
+        // Degenerate contour, every point sits at the same spot
+        std::fill(result.x.begin(), result.x.end(), contour.x[0]);
+        std::fill(result.y.begin(), result.y.end(), contour.y[0]);
+        result.updateBounds();
+        return result;
+    }
+
+    double step = perimeter / static_cast<double>(pointCount);
+    size_t edge = 0;
+    for (size_t k = 0; k < pointCount; ++k) {
+        double target = k * step;
+        while (edge + 1 < n && arcLength[edge + 1] <= target) {
+            ++edge;
+        }
+        size_t next = (edge + 1) % n;
+        double edgeLength = arcLength[edge + 1] - arcLength[edge];
+        double t = edgeLength > 0.0 ? (target - arcLength[edge]) / edgeLength : 0.0;
+        result.x[k] = contour.x[edge] + t * (contour.x[next] - contour.x[edge]);
+        result.y[k] = contour.y[edge] + t * (contour.y[next] - contour.y[edge]);
+    }
+    result.updateBounds();
+    return result;
+}
+
+void alignContour(const ContourGeometry& reference, ContourGeometry& target) {
+    size_t n = target.size();
+    if (n == 0 || reference.size() != n) {
+        return;
+    }
+
+    // Opposite winding would make corresponding points travel across the shape
+    if ((signedArea(reference) > 0.0) != (signedArea(target) > 0.0)) {
+        std::reverse(target.x.begin(), target.x.end());
+        std::reverse(target.y.begin(), target.y.end());
+    }
+
+    // Anchor on the point nearest to the reference start
+    size_t best = 0;
+    double bestDistance = -1.0;
+    for (size_t i = 0; i < n; ++i) {
+        double dx = target.x[i] - reference.x[0];
+        double dy = target.y[i] - reference.y[0];
+        double distance = dx * dx + dy * dy;
+        if (bestDistance < 0.0 || distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    std::rotate(target.x.begin(), target.x.begin() + best, target.x.end());
+    std::rotate(target.y.begin(), target.y.begin() + best, target.y.end());
+}
+
+void matchContours(const ContourGeometry& a, const ContourGeometry& b,
+                   ContourGeometry& matchedA, ContourGeometry& matchedB) {
+    size_t pointCount = std::max(a.size(), b.size());
+    matchedA = resampleContour(a, pointCount);
+    matchedB = resampleContour(b, pointCount);
+    alignContour(matchedA, matchedB);
+}
+
+}
@@ -0,0 +1,177 @@
+#include "ThumbnailLoader.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+// DCMTK Headers
+#include "dcmtk/dcmimgle/dcmimage.h"
+
+namespace fs = std::filesystem;
+
+// Tasks keep this alive, so a loader can go away while a decode is still running
+struct ThumbnailLoader::SharedState {
+    std::atomic<bool> cancelled{false};
+    std::mutex mutex;                   // Guards loader
+    ThumbnailLoader* loader = nullptr;  // Cleared by cancel(), before the loader is destroyed
+};
+
+namespace {
+// Pool task that produces one thumbnail and hands it back through the loader's signal
+class ThumbnailTask : public QRunnable {
+public:
+    ThumbnailTask(std::shared_ptr<ThumbnailLoader::SharedState> shared, int row, std::string seriesPath,
+                  int thumbnailSize)
+        : m_shared(std::move(shared)), m_row(row), m_seriesPath(std::move(seriesPath)),
+          m_thumbnailSize(thumbnailSize) {}
+
+    void run() override {
+        if (m_shared->cancelled) return;
+        QImage image = ThumbnailLoader::loadOrGenerate(m_seriesPath, m_thumbnailSize);
+        if (image.isNull()) return;
+
+        // Holding the lock keeps the loader alive while emitting. Emitting from a pool thread
+        // makes Qt queue the signal onto the GUI thread.
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        if (m_shared->loader) {
+            emit m_shared->loader->thumbnailReady(m_row, image);
+        }
+    }
+
+private:
+    std::shared_ptr<ThumbnailLoader::SharedState> m_shared;
+    int m_row;
+    std::string m_seriesPath;
+    int m_thumbnailSize;
+};
+}
+
+// Constructs a loader, tasks run on the global thread pool
+ThumbnailLoader::ThumbnailLoader(int thumbnailSize, QObject *parent)
+    : QObject(parent),
+      m_shared(std::make_shared<SharedState>()),
+      m_thumbnailSize(thumbnailSize)
+{
+    m_shared->loader = this;
+}
+
+ThumbnailLoader::~ThumbnailLoader() {
+    cancel();
+}
+
+// Queues thumbnail generation for a single series
+void ThumbnailLoader::request(int row, const std::string& seriesPath) {
+    QThreadPool::globalInstance()->start(new ThumbnailTask(m_shared, row, seriesPath, m_thumbnailSize));
+}
+
+// Detaches from outstanding work without blocking the GUI thread. Queued tasks return at once,
+// tasks that already started finish their single slice decode and drop the result.
+void ThumbnailLoader::cancel() {
+    m_shared->cancelled = true;
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->loader = nullptr;
+}
+
+// Returns the thumbnail for a series, generating and caching it on a cache miss
+QImage ThumbnailLoader::loadOrGenerate(const std::string& seriesPath, int thumbnailSize) {
+    std::string filePath = findMiddleSlice(seriesPath);
+    if (filePath.empty()) {
+        return QImage();
+    }
+
+    // Try the on-disk cache first
+    QString cachePath = cachePathFor(filePath, thumbnailSize);
+    QImage image;
+    if (!cachePath.isEmpty() && QFileInfo::exists(cachePath) && image.load(cachePath, "PNG")) {
+        return image;
+    }
+
+    image = decodeThumbnail(filePath, thumbnailSize);
+    if (!image.isNull() && !cachePath.isEmpty()) {
+        // QSaveFile writes to a unique temporary file and renames it on commit, so concurrent
+        // writers never clobber each other and readers never see a partial file
+        QDir().mkpath(QFileInfo(cachePath).absolutePath());
+        QSaveFile file(cachePath);
+        if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG")) {
+            file.commit();
+        }
+    }
+    return image;
+}
+
+// Picks the middle DICOM file of a series directory
+std::string ThumbnailLoader::findMiddleSlice(const std::string& seriesPath) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(seriesPath, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".dcm") {
+            files.push_back(entry.path().string());
+        }
+    }
+    if (files.empty()) {
+        return std::string();
+    }
+    // File names are a cheap stand-in for instance numbers, no headers are parsed here
+    std::sort(files.begin(), files.end());
+    return files[files.size() / 2];
+}
+
+// Builds the cache file path for a slice
+QString ThumbnailLoader::cachePathFor(const std::string& filePath, int thumbnailSize) {
+    QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheRoot.isEmpty()) {
+        return QString();
+    }
+
+    // Any change to the source file or the requested size produces a new key
+    QFileInfo info(QString::fromStdString(filePath));
+    QByteArray key = info.absoluteFilePath().toUtf8();
+    key += '|' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    key += '|' + QByteArray::number(info.size());
+    key += '|' + QByteArray::number(thumbnailSize);
+    QString hash = QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex());
+    return cacheRoot + "/thumbnails/" + hash + ".png";
+}
+
+// Decodes a slice and downsamples it to the thumbnail size
+QImage ThumbnailLoader::decodeThumbnail(const std::string& filePath, int thumbnailSize) {
+    DicomImage image(filePath.c_str());
+    if (image.getStatus() != EIS_Normal || image.getWidth() == 0 || image.getHeight() == 0) {
+        return QImage();
+    }
+
+    // Keep the aspect ratio, the longest side becomes thumbnailSize
+    unsigned long width = image.getWidth();
+    unsigned long height = image.getHeight();
+    double scale = static_cast<double>(thumbnailSize) / std::max(width, height);
+    unsigned long scaledWidth = std::max(1UL, static_cast<unsigned long>(width * scale));
+    unsigned long scaledHeight = std::max(1UL, static_cast<unsigned long>(height * scale));
+
+    std::unique_ptr<DicomImage> scaled(image.createScaledImage(scaledWidth, scaledHeight, 1 /*interpolate*/));
+    if (!scaled || scaled->getStatus() != EIS_Normal) {
+        return QImage();
+    }
+
+    // Window on the min/max of the slice, ignoring extreme values
+    scaled->setMinMaxWindow(1);
+    const Uint8* pixels = static_cast<const Uint8*>(scaled->getOutputData(8));
+    if (!pixels) {
+        return QImage();
+    }
+
+    // Copy row by row because QImage scanlines are 32-bit aligned
+    QImage thumbnail(static_cast<int>(scaledWidth), static_cast<int>(scaledHeight), QImage::Format_Grayscale8);
+    for (unsigned long y = 0; y < scaledHeight; ++y) {
+        std::copy(pixels + y * scaledWidth, pixels + (y + 1) * scaledWidth, thumbnail.scanLine(static_cast<int>(y)));
+    }
+    return thumbnail;
+}
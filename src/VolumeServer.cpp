@@ -0,0 +1,253 @@
+#include "VolumeServer.h"
+#include "DicomManager.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <iostream>
+#include <iterator>
+#include <unistd.h>
+
+namespace {
+constexpr int kProbeTimeoutMs = 500; // How long listen() waits for an existing server to answer
+
+// Response helpers
+QJsonObject errorResponse(const QString& message) {
+    QJsonObject response;
+    response["ok"] = false;
+    response["error"] = message;
+    return response;
+}
+
+QJsonArray toJsonArray(const std::vector<double>& values) {
+    QJsonArray array;
+    for (double value : values) {
+        array.append(value);
+    }
+    return array;
+}
+}
+
+// Constructs the server, it does not listen until listen() is called
+VolumeServer::VolumeServer(const DicomManager& dicomManager, QObject *parent)
+    : QObject(parent),
+      m_server(new QLocalServer(this)),
+      m_dicomManager(dicomManager)
+{
+    connect(m_server, &QLocalServer::newConnection, this, &VolumeServer::onNewConnection);
+}
+
+VolumeServer::~VolumeServer() {}
+
+// Starts listening on the socket
+bool VolumeServer::listen(const QString& name) {
+    // Only the current user may connect, the buffers hold patient data
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    // Only a socket nobody answers on was left behind by a crash, a live viewer keeps its name
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(kProbeTimeoutMs)) {
+        probe.disconnectFromServer();
+        std::cerr << "Error: Volume server cannot listen on " << name.toStdString()
+                  << ": another server is running there" << std::endl;
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        std::cerr << "Error: Volume server cannot listen on " << name.toStdString() << ": "
+                  << m_server->errorString().toStdString() << std::endl;
+        return false;
+    }
+    std::cout << "Volume server listening on " << serverName().toStdString() << std::endl;
+    return true;
+}
+
+QString VolumeServer::serverName() const {
+    return m_server->fullServerName();
+}
+
+// Drops the buffers of the previous study, mapped clients keep their copy until they unmap
+void VolumeServer::studyChanged() {
+    m_regions.clear();
+    ++m_generation;
+}
+
+// Accepts a connection and hooks up its request handling
+void VolumeServer::onNewConnection() {
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, &VolumeServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &VolumeServer::onDisconnected);
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+    }
+}
+
+// A client that goes away without releasing must not keep its regions alive
+void VolumeServer::onDisconnected() {
+    releaseClient(sender());
+}
+
+void VolumeServer::releaseClient(const QObject* client) {
+    for (auto it = m_regions.begin(); it != m_regions.end();) {
+        it->second.clients.erase(client);
+        it = it->second.clients.empty() ? m_regions.erase(it) : std::next(it);
+    }
+}
+
+// Answers every complete line received from a client
+void VolumeServer::onReadyRead() {
+    auto* socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) return;
+
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        QJsonObject response = document.isObject()
+            ? handleRequest(document.object(), socket)
+            : errorResponse("malformed request: " + parseError.errorString());
+
+        socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact));
+        socket->write("\n");
+    }
+}
+
+// Dispatches a request to its handler
+QJsonObject VolumeServer::handleRequest(const QJsonObject& request, const QObject* client) {
+    QString cmd = request.value("cmd").toString();
+    if (cmd == "info") return handleInfo();
+    if (cmd == "timepoint") return handleTimepoint(request, client);
+    if (cmd == "set_contour") return handleSetContour(request);
+    if (cmd == "release") return handleRelease(request, client);
+    return errorResponse("unknown command: " + cmd);
+}
+
+// Summary of the loaded study
+QJsonObject VolumeServer::handleInfo() const {
+    QJsonArray series;
+    for (const auto& pair : m_dicomManager.getSeries()) {
+        QJsonObject entry;
+        entry["path"] = QString::fromStdString(pair.first);
+        entry["frames"] = static_cast<int>(pair.second.size());
+        series.append(entry);
+    }
+
+    QJsonObject response;
+    response["ok"] = true;
+    response["timepoints"] = m_dicomManager.getNumberOfFrames();
+    response["series"] = series;
+    response["dtype"] = "float32";
+    return response;
+}
+
+// Decodes a timepoint into shared memory on first use and describes its layout
+QJsonObject VolumeServer::handleTimepoint(const QJsonObject& request, const QObject* client) {
+    int timeIndex = request.value("index").toInt(-1);
+    if (timeIndex < 0 || timeIndex >= m_dicomManager.getNumberOfFrames()) {
+        return errorResponse("timepoint index out of range");
+    }
+
+    // Same order as the slices of the viewer's scene
+    std::vector<DicomFrame> frames = m_dicomManager.getFramesForTimepoint(timeIndex);
+
+    QJsonArray frameArray;
+    size_t totalBytes = 0;
+    for (const auto& frame : frames) {
+        QJsonObject entry;
+        entry["file"] = QString::fromStdString(frame.filePath);
+        entry["contourFile"] = QString::fromStdString(frame.contourFilePath);
+        entry["instanceNumber"] = frame.instanceNumber;
+        entry["rows"] = frame.rows;
+        entry["cols"] = frame.cols;
+        entry["imagePosition"] = toJsonArray(frame.imagePosition);
+        entry["imageOrientation"] = toJsonArray(frame.imageOrientation);
+        entry["pixelSpacing"] = toJsonArray(frame.pixelSpacing);
+        entry["offset"] = static_cast<double>(totalBytes);
+        frameArray.append(entry);
+        totalBytes += static_cast<size_t>(frame.rows) * frame.cols * sizeof(float);
+    }
+
+    auto it = m_regions.find(timeIndex);
+    if (it == m_regions.end()) {
+        // Slices are packed back to back, each one rows * cols float32 values in row order
+        auto region = std::make_unique<SharedMemoryRegion>();
+        std::string name = "/dicomviewer-" + std::to_string(getpid()) + "-" +
+                           std::to_string(m_generation) + "-t" + std::to_string(timeIndex);
+        if (!region->create(name, totalBytes)) {
+            return errorResponse("cannot create shared memory");
+        }
+
+        char* base = static_cast<char*>(region->data());
+        size_t offset = 0;
+        for (const auto& frame : frames) {
+            if (!DicomManager::decodeFrame(frame, reinterpret_cast<float*>(base + offset))) {
+                return errorResponse("cannot decode " + QString::fromStdString(frame.filePath));
+            }
+            offset += static_cast<size_t>(frame.rows) * frame.cols * sizeof(float);
+        }
+        it = m_regions.emplace(timeIndex, PublishedTimepoint{std::move(region), {}}).first;
+    }
+    it->second.clients.insert(client);
+
+    QJsonObject response;
+    response["ok"] = true;
+    response["timepoint"] = timeIndex;
+    response["shm"] = QString::fromStdString(it->second.region->name());
+    response["bytes"] = static_cast<double>(it->second.region->size());
+    response["dtype"] = "float32";
+    // decodeFrame applies the rescale, the viewer itself shows stored values
+    response["values"] = "modality";
+    response["frames"] = frameArray;
+    return response;
+}
+
+// Validates a contour from a client and hands it to the viewer
+QJsonObject VolumeServer::handleSetContour(const QJsonObject& request) {
+    int timeIndex = request.value("timepoint").toInt(-1);
+    int sliceIndex = request.value("slice").toInt(-1);
+    std::vector<DicomFrame> frames = m_dicomManager.getFramesForTimepoint(timeIndex);
+    if (sliceIndex < 0 || sliceIndex >= static_cast<int>(frames.size())) {
+        return errorResponse("timepoint or slice index out of range");
+    }
+
+    QJsonArray xs = request.value("x").toArray();
+    QJsonArray ys = request.value("y").toArray();
+    if (xs.size() != ys.size() || xs.size() < 2) {
+        return errorResponse("x and y must hold the same number of points, at least 2");
+    }
+
+    ContourGeometry contour;
+    contour.x.reserve(xs.size());
+    contour.y.reserve(ys.size());
+    for (int i = 0; i < xs.size(); ++i) {
+        contour.x.push_back(xs[i].toDouble());
+        contour.y.push_back(ys[i].toDouble());
+    }
+    contour.updateBounds();
+
+    emit contourWritten(QString::fromStdString(frames[sliceIndex].filePath), contour);
+
+    QJsonObject response;
+    response["ok"] = true;
+    response["file"] = QString::fromStdString(frames[sliceIndex].filePath);
+    return response;
+}
+
+// Drops the client's hold on a timepoint, the region is unlinked when no other client holds it
+QJsonObject VolumeServer::handleRelease(const QJsonObject& request, const QObject* client) {
+    int timeIndex = request.value("index").toInt(-1);
+    auto it = m_regions.find(timeIndex);
+    if (it == m_regions.end() || it->second.clients.erase(client) == 0) {
+        return errorResponse("timepoint is not published for this connection");
+    }
+    if (it->second.clients.empty()) {
+        m_regions.erase(it);
+    }
+
+    QJsonObject response;
+    response["ok"] = true;
+    return response;
+}
@@ -1,4 +1,6 @@
 #include "VtkManager.h"
+#include "AllocationProfiler.h"
+#include "TemporalInterpolation.h"
 // VTK Includes
 #include <vtkGenericOpenGLRenderWindow.h>
 #include <vtkRenderer.h>
@@ -17,13 +19,17 @@
 #include <vtkProperty.h>
 #include <vtkRendererCollection.h>
 #include <vtkImageFlip.h>
+#include <vtkImageData.h>
+#include <vtkTextActor.h>
+#include <vtkTextProperty.h>
+#include <vtkImageCast.h>
 
 // Math Library
 #include <eigen3/Eigen/Dense>
 #include <algorithm>
-
-// Read numpy files
-#include "cnpy.h"
+#include <cmath>
+#include <filesystem>
+#include <iostream>
 
 
 // Constructs a VtkManager and initializes VTK components
@@ -40,6 +46,16 @@ VtkManager::VtkManager() {
     m_imageProperty->SetColorWindow(1000);
     m_imageProperty->SetColorLevel(500);
     m_imageProperty->SetInterpolationTypeToLinear();
+
+    // Debug overlay in the top left corner, hidden until it gets text
+    m_debugOverlay = vtkSmartPointer<vtkTextActor>::New();
+    m_debugOverlay->GetTextProperty()->SetFontFamilyToCourier();
+    m_debugOverlay->GetTextProperty()->SetFontSize(12);
+    m_debugOverlay->GetTextProperty()->SetColor(1.0, 1.0, 1.0);
+    m_debugOverlay->GetTextProperty()->SetVerticalJustificationToTop();
+    m_debugOverlay->GetPositionCoordinate()->SetCoordinateSystemToNormalizedViewport();
+    m_debugOverlay->SetPosition(0.01, 0.99);
+    m_debugOverlay->SetVisibility(false);
 }
 
 VtkManager::~VtkManager() {}
@@ -53,6 +69,7 @@ void VtkManager::setup(QVTKOpenGLNativeWidget* widget) {
 
 // Resets the camera to frame all objects in the scene and applies a zoom
 void VtkManager::resetCamera() {
+    AllocationProfiler::PhaseScope renderPhase(AllocPhase::Render);
     m_renderer->ResetCamera();
     m_renderer->GetActiveCamera()->Zoom(1.5);
     m_renderWindow->Render();
@@ -87,29 +104,13 @@ vtkSmartPointer<vtkMatrix4x4> VtkManager::createTransformMatrix(const DicomFrame
     return vtk_matrix;
 }
 
-// Creates a contour actor from numpy contour data
-vtkSmartPointer<vtkActor> VtkManager::createContourActor(const DicomFrame& frame) {
-    // Check if contour file exists
-    if (frame.contourFilePath.empty()) {
-        return nullptr;
-    }   
-
-    // Validate numpy array shape (should be 2xN)
-    cnpy::NpyArray arr = cnpy::npy_load(frame.contourFilePath);
-    if (arr.shape.size() != 2 || arr.shape[0] != 2) {
-        std::cerr << "Warning: Contour file " << frame.contourFilePath 
-                  << " has incorrect shape. Expected (2, N).\n";
-        return nullptr;
-    }
-
-    // Get pointer to contour data and number of points
-    double* data = arr.data<double>();
-    size_t num_points = arr.shape[1];
-
+// Creates a contour actor from contour points
+vtkSmartPointer<vtkActor> VtkManager::createContourActor(const DicomFrame& frame, const ContourGeometry& contour) {
     // Need at least 2 points to form a contour
-    if (num_points < 2) {
+    if (contour.empty()) {
         return nullptr;
     }
+    size_t num_points = contour.size();
 
     // Get transformation matrix for this frame
     vtkSmartPointer<vtkMatrix4x4> transform = createTransformMatrix(frame);
@@ -118,18 +119,14 @@ vtkSmartPointer<vtkActor> VtkManager::createContourActor(const DicomFrame& frame
     auto points = vtkSmartPointer<vtkPoints>::New();
     auto lines = vtkSmartPointer<vtkCellArray>::New();
 
-    // Extract x and y coordinates from numpy array
-    double* x_coords = data;
-    double* y_coords = data + num_points;
-
     // Create a polyline connecting all contour points
     lines->InsertNextCell(num_points + 1);
 
     // Process each contour point
     for (size_t i = 0; i < num_points; ++i) {
         // Get pixel coordinates
-        double pixel_x = x_coords[i];
-        double pixel_y = y_coords[i];   
+        double pixel_x = contour.x[i];
+        double pixel_y = contour.y[i];
         
         // Convert pixel coordinates to millimeter coordinates
         double mm_x = pixel_x * frame.pixelSpacing[1];
@@ -169,23 +166,31 @@ vtkSmartPointer<vtkActor> VtkManager::createContourActor(const DicomFrame& frame
 
 // Creates a new scene from a set of DICOM frames
 void VtkManager::createScene(const std::vector<DicomFrame>& frames) {
-    // Clear previous scene
-    m_renderer->RemoveAllViewProps();
-    m_sliceActors.clear();
-    m_contourActors.clear();
+    AllocationProfiler::PhaseScope scenePhase(AllocPhase::SceneBuild);
+
+    // Clear previous scene, including any interpolation state
+    clearScene();
+    m_floatImageCache.clear();
+
+    std::vector<SlicePlane> planes;
+    planes.reserve(frames.size());
 
     // Process each DICOM frame
     for (const auto& frame : frames) {
-        // Read DICOM image
         auto reader = vtkSmartPointer<vtkDICOMImageReader>::New();
-        reader->SetFileName(frame.filePath.c_str());
-        reader->Update();
-
-        // Flip image vertically
         auto flipY = vtkSmartPointer<vtkImageFlip>::New();
-        flipY->SetFilteredAxis(1); // axis 1 = Y
-        flipY->SetInputConnection(reader->GetOutputPort());
-        flipY->Update();
+        {
+            AllocationProfiler::PhaseScope decodePhase(AllocPhase::Decode);
+
+            // Read DICOM image
+            reader->SetFileName(frame.filePath.c_str());
+            reader->Update();
+
+            // Flip image vertically
+            flipY->SetFilteredAxis(1); // axis 1 = Y
+            flipY->SetInputConnection(reader->GetOutputPort());
+            flipY->Update();
+        }
         
         // Create transformation matrix from DICOM metadata
         vtkSmartPointer<vtkMatrix4x4> transform = createTransformMatrix(frame);
@@ -207,13 +212,253 @@ void VtkManager::createScene(const std::vector<DicomFrame>& frames) {
         m_sliceActors.push_back(imageActor);
         m_renderer->AddViewProp(imageActor);
 
+        // Keep the decoded image for probing and describe the slice rectangle for the index
+        m_sliceFrames.push_back(frame);
+        m_sliceImages.push_back(flipY->GetOutput());
+        planes.push_back(createSlicePlane(frame, transform, static_cast<int>(m_sliceActors.size()) - 1));
+
+        AllocationProfiler::PhaseScope contourPhase(AllocPhase::Contour);
+
+        // Load the contour once, it feeds both the actor and point in contour tests
+        ContourGeometry contour;
+        loadSliceContour(frame, contour);
+
         // Create and add contour if available
-        vtkSmartPointer<vtkActor> contourActor = createContourActor(frame);
+        vtkSmartPointer<vtkActor> contourActor = createContourActor(frame, contour);
         if (contourActor) {
-            m_contourActors.push_back(contourActor);
             m_renderer->AddViewProp(contourActor);
         }
+        m_contourActors.push_back(contourActor);
+        m_sliceContours.push_back(std::move(contour));
     }
+
+    m_sliceIndex.build(planes);
+}
+
+// Removes every actor except the debug overlay and forgets the per slice data
+void VtkManager::clearScene() {
+    m_renderer->RemoveAllViewProps();
+    m_renderer->AddViewProp(m_debugOverlay);
+    m_sliceActors.clear();
+    m_contourActors.clear();
+    m_sliceFrames.clear();
+    m_sliceImages.clear();
+    m_sliceContours.clear();
+    m_sliceIndex.clear();
+    m_blendSlices.clear();
+    m_blendFramesA.clear();
+    m_blendFramesB.clear();
+}
+
+// Loads the contour of a frame
+void VtkManager::loadSliceContour(const DicomFrame& frame, ContourGeometry& contour) const {
+    auto overrideIt = m_contourOverrides.find(frame.filePath);
+    if (overrideIt != m_contourOverrides.end()) {
+        contour = overrideIt->second;
+    } else {
+        ContourGeometry::loadFromNpy(frame.contourFilePath, contour);
+    }
+}
+
+// Builds the actors of an interpolated scene, the blended buffers start at the last alpha
+void VtkManager::setInterpolatedFrames(const std::vector<DicomFrame>& framesA, const std::vector<DicomFrame>& framesB) {
+    // Pair every slice of A with the slice of B from the same series folder
+    std::map<std::string, const DicomFrame*> framesByFolder;
+    for (const auto& frame : framesB) {
+        framesByFolder[std::filesystem::path(frame.filePath).parent_path().string()] = &frame;
+    }
+    std::vector<DicomFrame> matchedB;
+    matchedB.reserve(framesA.size());
+    for (const auto& frame : framesA) {
+        auto it = framesByFolder.find(std::filesystem::path(frame.filePath).parent_path().string());
+        // A series without this timepoint stays still
+        matchedB.push_back(it != framesByFolder.end() ? *it->second : frame);
+    }
+
+    buildBlendScene(framesA, matchedB);
+    m_blendFramesA = framesA;
+    m_blendFramesB = std::move(matchedB);
+    updateBlend(m_blendAlpha);
+}
+
+// Per frame step of an interpolated scene
+void VtkManager::setInterpolationAlpha(double alpha) {
+    m_blendAlpha = std::max(0.0, std::min(1.0, alpha));
+    updateBlend(m_blendAlpha);
+}
+
+// Float version of the same reader pipeline used by createScene
+vtkSmartPointer<vtkImageData> VtkManager::loadFloatImage(const DicomFrame& frame,
+                                                         std::map<std::string, vtkSmartPointer<vtkImageData>>& previous) {
+    auto cached = m_floatImageCache.find(frame.filePath);
+    if (cached != m_floatImageCache.end()) {
+        return cached->second;
+    }
+    auto reused = previous.find(frame.filePath);
+    if (reused != previous.end()) {
+        return m_floatImageCache[frame.filePath] = reused->second;
+    }
+
+    AllocationProfiler::PhaseScope decodePhase(AllocPhase::Decode);
+    auto reader = vtkSmartPointer<vtkDICOMImageReader>::New();
+    reader->SetFileName(frame.filePath.c_str());
+
+    auto flipY = vtkSmartPointer<vtkImageFlip>::New();
+    flipY->SetFilteredAxis(1); // axis 1 = Y
+    flipY->SetInputConnection(reader->GetOutputPort());
+
+    // The blend kernels work on float pixels
+    auto cast = vtkSmartPointer<vtkImageCast>::New();
+    cast->SetOutputScalarTypeToFloat();
+    cast->SetInputConnection(flipY->GetOutputPort());
+    cast->Update();
+
+    vtkSmartPointer<vtkImageData> image = cast->GetOutput();
+    return m_floatImageCache[frame.filePath] = image;
+}
+
+// Creates slice and contour actors whose data the blend kernels rewrite in place
+void VtkManager::buildBlendScene(const std::vector<DicomFrame>& framesA, const std::vector<DicomFrame>& framesB) {
+    AllocationProfiler::PhaseScope scenePhase(AllocPhase::SceneBuild);
+    clearScene();
+
+    // Images of the previous pair that are still needed move over, the rest is released
+    std::map<std::string, vtkSmartPointer<vtkImageData>> previous;
+    previous.swap(m_floatImageCache);
+
+    std::vector<SlicePlane> planes;
+    planes.reserve(framesA.size());
+
+    for (size_t i = 0; i < framesA.size(); ++i) {
+        const DicomFrame& frameA = framesA[i];
+        const DicomFrame& frameB = framesB[i];
+        BlendSlice slice;
+        slice.imageA = loadFloatImage(frameA, previous);
+        slice.imageB = loadFloatImage(frameB, previous);
+        if (slice.imageB->GetNumberOfPoints() != slice.imageA->GetNumberOfPoints()) {
+            slice.imageB = slice.imageA; // Mismatched acquisitions cannot be blended
+        }
+
+        // Output buffer with the geometry of timepoint A
+        slice.blended = vtkSmartPointer<vtkImageData>::New();
+        slice.blended->CopyStructure(slice.imageA);
+        slice.blended->AllocateScalars(VTK_FLOAT, 1);
+
+        vtkSmartPointer<vtkMatrix4x4> transform = createTransformMatrix(frameA);
+        auto imageActor = vtkSmartPointer<vtkImageActor>::New();
+        auto mapper = vtkSmartPointer<vtkImageSliceMapper>::New();
+        mapper->SetInputData(slice.blended);
+        imageActor->SetMapper(mapper);
+        imageActor->SetUserMatrix(transform);
+        imageActor->SetScale(frameA.pixelSpacing[1], frameA.pixelSpacing[0], 1.0);
+        imageActor->SetProperty(m_imageProperty);
+        m_sliceActors.push_back(imageActor);
+        m_renderer->AddViewProp(imageActor);
+
+        m_sliceFrames.push_back(frameA);
+        m_sliceImages.push_back(slice.blended);
+        planes.push_back(createSlicePlane(frameA, transform, static_cast<int>(i)));
+
+        AllocationProfiler::PhaseScope contourPhase(AllocPhase::Contour);
+        ContourGeometry contourA, contourB;
+        loadSliceContour(frameA, contourA);
+        loadSliceContour(frameB, contourB);
+
+        vtkSmartPointer<vtkActor> contourActor;
+        if (!contourA.empty() && !contourB.empty()) {
+            // Matched point counts let the contour be interpolated with the same kernel as the pixels
+            TemporalInterpolation::matchContours(contourA, contourB, slice.contourA, slice.contourB);
+            contourActor = createContourActor(frameA, slice.contourA);
+            slice.contourPoints = vtkPolyData::SafeDownCast(contourActor->GetMapper()->GetInput())->GetPoints();
+
+            size_t n = slice.contourA.size();
+            slice.worldA.resize(3 * n);
+            slice.worldB.resize(3 * n);
+            for (size_t p = 0; p < n; ++p) {
+                double localA[4] = {slice.contourA.x[p] * frameA.pixelSpacing[1], slice.contourA.y[p] * frameA.pixelSpacing[0], 0.0, 1.0};
+                double localB[4] = {slice.contourB.x[p] * frameA.pixelSpacing[1], slice.contourB.y[p] * frameA.pixelSpacing[0], 0.0, 1.0};
+                double worldA[4], worldB[4];
+                transform->MultiplyPoint(localA, worldA);
+                transform->MultiplyPoint(localB, worldB);
+                for (int axis = 0; axis < 3; ++axis) {
+                    slice.worldA[3 * p + axis] = static_cast<float>(worldA[axis]);
+                    slice.worldB[3 * p + axis] = static_cast<float>(worldB[axis]);
+                }
+            }
+            m_sliceContours.push_back(slice.contourA);
+        } else {
+            // Only one side has a contour, show it while its timepoint is the nearer one
+            slice.nearestA = createContourActor(frameA, contourA);
+            slice.nearestB = createContourActor(frameB, contourB);
+            if (slice.nearestB) m_renderer->AddViewProp(slice.nearestB);
+            contourActor = slice.nearestA;
+            slice.contourA = contourA;
+            slice.contourB = contourB;
+            m_sliceContours.push_back(contourA);
+        }
+        if (contourActor) {
+            m_renderer->AddViewProp(contourActor);
+        }
+        m_contourActors.push_back(contourActor);
+        m_blendSlices.push_back(std::move(slice));
+    }
+
+    m_sliceIndex.build(planes);
+}
+
+// Per displayed frame work: SIMD blends into the existing buffers, no allocations
+void VtkManager::updateBlend(double alpha) {
+    float weight = static_cast<float>(alpha);
+    for (size_t i = 0; i < m_blendSlices.size(); ++i) {
+        BlendSlice& slice = m_blendSlices[i];
+
+        TemporalInterpolation::blendImages(static_cast<const float*>(slice.imageA->GetScalarPointer()),
+                                           static_cast<const float*>(slice.imageB->GetScalarPointer()),
+                                           static_cast<float*>(slice.blended->GetScalarPointer()),
+                                           static_cast<size_t>(slice.blended->GetNumberOfPoints()), weight);
+        slice.blended->Modified();
+
+        if (slice.contourPoints) {
+            // vtkPoints stores float xyz triples, the same layout as worldA and worldB
+            TemporalInterpolation::blendImages(slice.worldA.data(), slice.worldB.data(),
+                                               static_cast<float*>(slice.contourPoints->GetVoidPointer(0)),
+                                               slice.worldA.size(), weight);
+            slice.contourPoints->Modified();
+
+            // Keep the pixel space contour used by the cursor probe in step
+            ContourGeometry& contour = m_sliceContours[i];
+            TemporalInterpolation::blendPoints(slice.contourA.x.data(), slice.contourB.x.data(), contour.x.data(), contour.size(), alpha);
+            TemporalInterpolation::blendPoints(slice.contourA.y.data(), slice.contourB.y.data(), contour.y.data(), contour.size(), alpha);
+            contour.updateBounds();
+        } else {
+            bool showA = alpha < 0.5;
+            if (slice.nearestA) slice.nearestA->SetVisibility(showA);
+            if (slice.nearestB) slice.nearestB->SetVisibility(!showA);
+            // Copy-assign reuses the existing vector capacity after the first switch
+            m_sliceContours[i] = showA ? slice.contourA : slice.contourB;
+        }
+    }
+}
+
+// Describes the world space rectangle covered by a slice actor
+SlicePlane VtkManager::createSlicePlane(const DicomFrame& frame, vtkMatrix4x4* transform, int sliceIndex) {
+    SlicePlane plane;
+    for (int i = 0; i < 3; ++i) {
+        plane.row[i] = transform->GetElement(i, 0);
+        plane.col[i] = transform->GetElement(i, 1);
+        plane.normal[i] = transform->GetElement(i, 2);
+        plane.origin[i] = transform->GetElement(i, 3);
+    }
+
+    // Pixels are centred on their index, so the image reaches half a pixel past the first and last centre
+    double spacingX = frame.pixelSpacing[1];
+    double spacingY = frame.pixelSpacing[0];
+    plane.minU = -0.5 * spacingX;
+    plane.maxU = (frame.cols - 0.5) * spacingX;
+    plane.minV = -0.5 * spacingY;
+    plane.maxV = (frame.rows - 0.5) * spacingY;
+    plane.sliceIndex = sliceIndex;
+    return plane;
 }
 
 // Sets the opacity of all image slices
@@ -229,3 +474,133 @@ void VtkManager::setSliceOpacity(double opacity) {
         }
     }
 }
+
+// Updates the shared image property, every slice actor picks it up on the next render
+void VtkManager::setWindowLevel(double window, double level) {
+    m_imageProperty->SetColorWindow(window);
+    m_imageProperty->SetColorLevel(level);
+
+    if (m_renderWindow && m_renderWindow->GetRenderers()->GetNumberOfItems() > 0) {
+        m_renderWindow->Render();
+    }
+}
+
+// Casts a ray from the camera through a display coordinate and reports what it hits first
+bool VtkManager::probe(double displayX, double displayY, ProbeResult& result) const {
+    result = ProbeResult();
+    if (m_sliceIndex.empty()) {
+        return false;
+    }
+
+    // Unproject the display point on the near and far clipping planes
+    double nearPoint[4], farPoint[4];
+    m_renderer->SetDisplayPoint(displayX, displayY, 0.0);
+    m_renderer->DisplayToWorld();
+    m_renderer->GetWorldPoint(nearPoint);
+    m_renderer->SetDisplayPoint(displayX, displayY, 1.0);
+    m_renderer->DisplayToWorld();
+    m_renderer->GetWorldPoint(farPoint);
+    if (nearPoint[3] == 0.0 || farPoint[3] == 0.0) {
+        return false;
+    }
+
+    Eigen::Vector3d origin(nearPoint[0] / nearPoint[3], nearPoint[1] / nearPoint[3], nearPoint[2] / nearPoint[3]);
+    Eigen::Vector3d target(farPoint[0] / farPoint[3], farPoint[1] / farPoint[3], farPoint[2] / farPoint[3]);
+
+    SliceHit hit;
+    if (!m_sliceIndex.intersectRay(origin, target - origin, hit)) {
+        return false;
+    }
+
+    // Local mm coordinates back to pixel indices
+    const DicomFrame& frame = m_sliceFrames[hit.sliceIndex];
+    double pixelX = hit.u / frame.pixelSpacing[1];
+    double pixelY = hit.v / frame.pixelSpacing[0];
+
+    result.hit = true;
+    result.world[0] = hit.world.x();
+    result.world[1] = hit.world.y();
+    result.world[2] = hit.world.z();
+    result.sliceIndex = hit.sliceIndex;
+    result.pixelI = std::max(0, std::min(frame.cols - 1, static_cast<int>(std::lround(pixelX))));
+    result.pixelJ = std::max(0, std::min(frame.rows - 1, static_cast<int>(std::lround(pixelY))));
+
+    // The flipped image is stored in DICOM row order, matching the local axes of the actor
+    vtkImageData* image = m_sliceImages[hit.sliceIndex];
+    if (image) {
+        int extent[6];
+        image->GetExtent(extent);
+        int i = extent[0] + result.pixelI;
+        int j = extent[2] + result.pixelJ;
+        if (i <= extent[1] && j <= extent[3]) {
+            result.intensity = image->GetScalarComponentAsDouble(i, j, extent[4], 0);
+        }
+    }
+
+    const ContourGeometry& contour = m_sliceContours[hit.sliceIndex];
+    result.hasContour = !contour.empty();
+    result.insideContour = contour.contains(pixelX, pixelY);
+    return true;
+}
+
+// Stores a contour override and swaps the contour actor if the file is part of the current scene
+void VtkManager::overrideContour(const std::string& filePath, const ContourGeometry& contour) {
+    AllocationProfiler::PhaseScope contourPhase(AllocPhase::Contour);
+    m_contourOverrides[filePath] = contour;
+
+    // Interpolated scenes are rebuilt right away, playback may be paused on this frame
+    if (!m_blendFramesA.empty()) {
+        auto usesFile = [&filePath](const DicomFrame& frame) { return frame.filePath == filePath; };
+        if (std::none_of(m_blendFramesA.begin(), m_blendFramesA.end(), usesFile) &&
+            std::none_of(m_blendFramesB.begin(), m_blendFramesB.end(), usesFile)) {
+            return;
+        }
+
+        // buildBlendScene clears the scene, frame lists included, and reuses the cached images
+        std::vector<DicomFrame> framesA = std::move(m_blendFramesA);
+        std::vector<DicomFrame> framesB = std::move(m_blendFramesB);
+        buildBlendScene(framesA, framesB);
+        m_blendFramesA = std::move(framesA);
+        m_blendFramesB = std::move(framesB);
+        updateBlend(m_blendAlpha);
+
+        if (m_renderWindow && m_renderWindow->GetRenderers()->GetNumberOfItems() > 0) {
+            m_renderWindow->Render();
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < m_sliceFrames.size(); ++i) {
+        if (m_sliceFrames[i].filePath != filePath) continue;
+
+        if (m_contourActors[i]) {
+            m_renderer->RemoveViewProp(m_contourActors[i]);
+        }
+        m_contourActors[i] = createContourActor(m_sliceFrames[i], contour);
+        if (m_contourActors[i]) {
+            m_renderer->AddViewProp(m_contourActors[i]);
+        }
+        m_sliceContours[i] = contour;
+
+        if (m_renderWindow && m_renderWindow->GetRenderers()->GetNumberOfItems() > 0) {
+            m_renderWindow->Render();
+        }
+    }
+}
+
+void VtkManager::clearContourOverrides() {
+    m_contourOverrides.clear();
+}
+
+vtkActor* VtkManager::contourActor(size_t sliceIndex) const {
+    return sliceIndex < m_contourActors.size() ? m_contourActors[sliceIndex].Get() : nullptr;
+}
+
+// Shows text in the corner of the view, an empty string hides the overlay
+void VtkManager::setDebugOverlayText(const std::string& text) {
+    m_debugOverlay->SetInput(text.c_str());
+    m_debugOverlay->SetVisibility(!text.empty());
+    if (!m_renderer->HasViewProp(m_debugOverlay)) {
+        m_renderer->AddViewProp(m_debugOverlay);
+    }
+}
@@ -0,0 +1,72 @@
+#include "WorkStealingScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+// Creates the per-worker queues, the threads themselves only live for the duration of run()
+WorkStealingScheduler::WorkStealingScheduler(unsigned workerCount)
+    : m_workerCount(workerCount)
+{
+    if (m_workerCount == 0) {
+        m_workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < m_workerCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+// Deals the tasks out and blocks until all of them have finished
+void WorkStealingScheduler::run(std::vector<Task> tasks) {
+    m_steals = 0;
+
+    // Round-robin keeps the expensive tasks at the front spread over all workers.
+    // Workers pop from the back, so push in reverse to start with the first dealt task.
+    for (size_t i = tasks.size(); i-- > 0;) {
+        m_queues[i % m_workerCount]->tasks.push_back(std::move(tasks[i]));
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(m_workerCount);
+    for (unsigned worker = 0; worker < m_workerCount; ++worker) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this, worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Runs tasks until neither the own queue nor any other queue has work left.
+// No tasks are added once run() started, so an empty sweep means the batch is done.
+void WorkStealingScheduler::workerLoop(unsigned worker) {
+    Task task;
+    while (nextTask(worker, task)) {
+        task(worker);
+        task = nullptr;
+    }
+}
+
+// Own queue first (LIFO), then the front of the other queues (FIFO)
+bool WorkStealingScheduler::nextTask(unsigned worker, Task& task) {
+    {
+        WorkerQueue& own = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Visit victims starting after ourselves so thieves do not all hit worker 0
+    for (unsigned offset = 1; offset < m_workerCount; ++offset) {
+        WorkerQueue& victim = *m_queues[(worker + offset) % m_workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            ++m_steals;
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,9 +1,36 @@
 #include "MainWindow.h"
+#include "BatchProcessor.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstring>
 
 int main(int argc, char *argv[]) {
+    // Headless batch mode never creates a window, so it runs on machines without a display
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            QCoreApplication app(argc, argv);
+            return BatchProcessor::runFromCommandLine(app.arguments());
+        }
+    }
+
     QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption serveOption("serve", "Publish loaded studies to local clients on the given socket.", "socket");
+    parser.addOption(serveOption);
+    QCommandLineOption allocOption("alloc-profile", "Show allocation counts per phase and write them as JSON to the given file.", "file");
+    parser.addOption(allocOption);
+    parser.process(app);
+
     MainWindow window;
+    if (parser.isSet(serveOption) && !window.startVolumeServer(parser.value(serveOption))) {
+        return 1;
+    }
+    if (parser.isSet(allocOption)) {
+        window.enableAllocationReport(parser.value(allocOption));
+    }
     window.show();
     return app.exec();
-}
\ No newline at end of file
+}
@@ -0,0 +1,341 @@
+#include "ContourGeometry.h"
+#include "DicomManager.h"
+#include "SyntheticStudy.h"
+#include "VolumeServer.h"
+#include "VtkManager.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <vtkActor.h>
+#include <vtkMapper.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+// True when shm_open finds the region, false once it is unlinked
+bool shmExists(const QByteArray& name) {
+    int fd = shm_open(name.constData(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+}
+}
+
+// Drives a VolumeServer over a real socket, the way an analysis tool would
+class VolumeServerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void info();
+    void timepoint();
+    void timepointSharedMemoryMatchesDecode();
+    void setContourReplacesDisplayedContour();
+    void releaseUnlinksRegion();
+    void releaseKeepsRegionOfOtherClients();
+    void listenRefusesLiveServerName();
+    void errorReplies_data();
+    void errorReplies();
+
+private:
+    // Sends one request line and waits for its response, an empty object on timeout
+    static QJsonObject send(QLocalSocket& client, const QByteArray& line);
+    QJsonObject send(const QByteArray& line);
+    QJsonObject send(const QJsonObject& request);
+    QJsonObject send(QLocalSocket& client, const QJsonObject& request);
+
+    // Points of a contour actor's polyline, null when the actor has none
+    static vtkPoints* contourPoints(vtkActor* actor);
+
+    QTemporaryDir m_tempDir;
+    SyntheticStudySpec m_spec;
+    DicomManager m_dicomManager;
+    VtkManager m_vtkManager; // Offscreen scene, receives contours like MainWindow does
+    std::unique_ptr<VolumeServer> m_server;
+    QLocalSocket m_client;
+};
+
+void VolumeServerTest::initTestCase() {
+    QVERIFY(m_tempDir.isValid());
+    QVERIFY(findSyntheticStudy("small", m_spec));
+
+    std::string studyPath = m_tempDir.filePath("study").toStdString();
+    QVERIFY(generateSyntheticStudy(m_spec, studyPath));
+    QVERIFY(m_dicomManager.loadSelectedSeries(studyPath, m_dicomManager.discoverSeries(studyPath)));
+
+    m_server = std::make_unique<VolumeServer>(m_dicomManager);
+    QVERIFY(m_server->listen(m_tempDir.filePath("volume.sock")));
+    connect(m_server.get(), &VolumeServer::contourWritten, this, [this](const QString& filePath, const ContourGeometry& contour) {
+        m_vtkManager.overrideContour(filePath.toStdString(), contour);
+    });
+
+    m_client.connectToServer(m_server->serverName());
+    QVERIFY(m_client.waitForConnected(5000));
+}
+
+void VolumeServerTest::cleanupTestCase() {
+    m_client.disconnectFromServer();
+    if (m_server) {
+        m_server->studyChanged(); // Unlinks whatever a failed test left published
+    }
+}
+
+QJsonObject VolumeServerTest::send(QLocalSocket& client, const QByteArray& line) {
+    client.write(line + "\n");
+    client.flush();
+
+    // The server lives in this thread, so keep its event loop turning while waiting
+    QElapsedTimer timer;
+    timer.start();
+    while (!client.canReadLine() && timer.elapsed() < 5000) {
+        QTest::qWait(5);
+    }
+    if (!client.canReadLine()) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(client.readLine()).object();
+}
+
+QJsonObject VolumeServerTest::send(const QByteArray& line) {
+    return send(m_client, line);
+}
+
+QJsonObject VolumeServerTest::send(const QJsonObject& request) {
+    return send(m_client, request);
+}
+
+QJsonObject VolumeServerTest::send(QLocalSocket& client, const QJsonObject& request) {
+    return send(client, QJsonDocument(request).toJson(QJsonDocument::Compact));
+}
+
+vtkPoints* VolumeServerTest::contourPoints(vtkActor* actor) {
+    vtkPolyData* polyData = actor ? vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput()) : nullptr;
+    return polyData ? polyData->GetPoints() : nullptr;
+}
+
+
+void VolumeServerTest::info() {
+    QJsonObject response = send(QJsonObject{{"cmd", "info"}});
+    QCOMPARE(response.value("ok").toBool(), true);
+    QCOMPARE(response.value("timepoints").toInt(), m_spec.timepoints);
+    QCOMPARE(response.value("series").toArray().size(), m_spec.seriesCount);
+    QCOMPARE(response.value("dtype").toString(), QString("float32"));
+}
+
+void VolumeServerTest::timepoint() {
+    QJsonObject response = send(QJsonObject{{"cmd", "timepoint"}, {"index", 3}});
+    QCOMPARE(response.value("ok").toBool(), true);
+    QCOMPARE(response.value("timepoint").toInt(), 3);
+    QVERIFY(response.value("shm").toString().startsWith('/'));
+
+    // Frames come in scene order with consecutive offsets
+    std::vector<DicomFrame> frames = m_dicomManager.getFramesForTimepoint(3);
+    QJsonArray frameArray = response.value("frames").toArray();
+    QCOMPARE(frameArray.size(), static_cast<int>(frames.size()));
+    double offset = 0.0;
+    for (int i = 0; i < frameArray.size(); ++i) {
+        QJsonObject frame = frameArray[i].toObject();
+        QCOMPARE(frame.value("file").toString(), QString::fromStdString(frames[i].filePath));
+        QCOMPARE(frame.value("rows").toInt(), m_spec.rows);
+        QCOMPARE(frame.value("cols").toInt(), m_spec.cols);
+        QCOMPARE(frame.value("offset").toDouble(), offset);
+        offset += static_cast<double>(m_spec.rows) * m_spec.cols * sizeof(float);
+    }
+    QCOMPARE(response.value("bytes").toDouble(), offset);
+    QCOMPARE(response.value("values").toString(), QString("modality"));
+
+    // A second request reuses the published region
+    QJsonObject again = send(QJsonObject{{"cmd", "timepoint"}, {"index", 3}});
+    QCOMPARE(again.value("shm").toString(), response.value("shm").toString());
+}
+
+void VolumeServerTest::timepointSharedMemoryMatchesDecode() {
+    const int timeIndex = 5;
+    QJsonObject response = send(QJsonObject{{"cmd", "timepoint"}, {"index", timeIndex}});
+    QCOMPARE(response.value("ok").toBool(), true);
+    size_t bytes = static_cast<size_t>(response.value("bytes").toDouble());
+
+    // Map the region exactly like a client process would
+    QByteArray name = response.value("shm").toString().toUtf8();
+    int fd = shm_open(name.constData(), O_RDONLY, 0);
+    QVERIFY2(fd >= 0, std::strerror(errno));
+    struct stat info;
+    QCOMPARE(fstat(fd, &info), 0);
+    QVERIFY(static_cast<size_t>(info.st_size) >= bytes);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    QVERIFY(mapping != MAP_FAILED);
+
+    const char* base = static_cast<const char*>(mapping);
+    std::vector<DicomFrame> frames = m_dicomManager.getFramesForTimepoint(timeIndex);
+    size_t offset = 0;
+    bool identical = true;
+    for (const auto& frame : frames) {
+        std::vector<float> decoded(static_cast<size_t>(frame.rows) * frame.cols);
+        QVERIFY(DicomManager::decodeFrame(frame, decoded.data()));
+        identical = identical && std::memcmp(base + offset, decoded.data(), decoded.size() * sizeof(float)) == 0;
+        offset += decoded.size() * sizeof(float);
+    }
+    munmap(mapping, bytes);
+    QCOMPARE(offset, bytes);
+    QVERIFY(identical);
+}
+
+void VolumeServerTest::setContourReplacesDisplayedContour() {
+    // Show the timepoint the contour is written to, with the contours from the npy files
+    std::vector<DicomFrame> frames = m_dicomManager.getFramesForTimepoint(2);
+    m_vtkManager.createScene(frames);
+    vtkPoints* before = contourPoints(m_vtkManager.contourActor(1));
+    QVERIFY(before);
+    QCOMPARE(before->GetNumberOfPoints(), static_cast<vtkIdType>(m_spec.contourPoints));
+
+    QString writtenFile;
+    ContourGeometry writtenContour;
+    int emissions = 0;
+    QMetaObject::Connection connection = connect(m_server.get(), &VolumeServer::contourWritten,
+        [&](const QString& filePath, const ContourGeometry& contour) {
+            writtenFile = filePath;
+            writtenContour = contour;
+            ++emissions;
+        });
+
+    QJsonObject request{{"cmd", "set_contour"}, {"timepoint", 2}, {"slice", 1},
+                        {"x", QJsonArray{10.0, 20.0, 20.0}}, {"y", QJsonArray{10.0, 10.0, 25.0}}};
+    QJsonObject response = send(request);
+    disconnect(connection);
+
+    QString expectedFile = QString::fromStdString(frames[1].filePath);
+    QCOMPARE(response.value("ok").toBool(), true);
+    QCOMPARE(response.value("file").toString(), expectedFile);
+    QCOMPARE(emissions, 1);
+    QCOMPARE(writtenFile, expectedFile);
+    QCOMPARE(writtenContour.size(), size_t(3));
+    QCOMPARE(writtenContour.x[1], 20.0);
+    QCOMPARE(writtenContour.y[2], 25.0);
+    QCOMPARE(writtenContour.maxY, 25.0);
+
+    // The displayed slice now shows the written points, placed like any other contour
+    vtkPoints* after = contourPoints(m_vtkManager.contourActor(1));
+    QVERIFY(after);
+    QCOMPARE(after->GetNumberOfPoints(), vtkIdType(3));
+    vtkPoints* expected = contourPoints(m_vtkManager.createContourActor(frames[1], writtenContour));
+    for (vtkIdType i = 0; i < 3; ++i) {
+        double actual[3];
+        double wanted[3];
+        after->GetPoint(i, actual);
+        expected->GetPoint(i, wanted);
+        QCOMPARE(actual[0], wanted[0]);
+        QCOMPARE(actual[1], wanted[1]);
+        QCOMPARE(actual[2], wanted[2]);
+    }
+
+    // Other slices keep their contours
+    vtkPoints* neighbour = contourPoints(m_vtkManager.contourActor(0));
+    QVERIFY(neighbour);
+    QCOMPARE(neighbour->GetNumberOfPoints(), static_cast<vtkIdType>(m_spec.contourPoints));
+}
+
+void VolumeServerTest::releaseUnlinksRegion() {
+    QJsonObject response = send(QJsonObject{{"cmd", "timepoint"}, {"index", 7}});
+    QCOMPARE(response.value("ok").toBool(), true);
+    QByteArray name = response.value("shm").toString().toUtf8();
+
+    QJsonObject released = send(QJsonObject{{"cmd", "release"}, {"index", 7}});
+    QCOMPARE(released.value("ok").toBool(), true);
+
+    errno = 0;
+    int fd = shm_open(name.constData(), O_RDONLY, 0);
+    if (fd >= 0) close(fd);
+    QCOMPARE(fd, -1);
+    QCOMPARE(errno, ENOENT);
+
+    // Releasing twice is reported, not ignored
+    QJsonObject again = send(QJsonObject{{"cmd", "release"}, {"index", 7}});
+    QCOMPARE(again.value("ok").toBool(), false);
+}
+
+void VolumeServerTest::releaseKeepsRegionOfOtherClients() {
+    QLocalSocket other;
+    other.connectToServer(m_server->serverName());
+    QVERIFY(other.waitForConnected(5000));
+
+    QJsonObject mine = send(QJsonObject{{"cmd", "timepoint"}, {"index", 4}});
+    QJsonObject theirs = send(other, QJsonObject{{"cmd", "timepoint"}, {"index", 4}});
+    QCOMPARE(mine.value("ok").toBool(), true);
+    QCOMPARE(theirs.value("shm").toString(), mine.value("shm").toString());
+    QByteArray name = mine.value("shm").toString().toUtf8();
+
+    // The other client still maps it
+    QCOMPARE(send(QJsonObject{{"cmd", "release"}, {"index", 4}}).value("ok").toBool(), true);
+    QVERIFY(shmExists(name));
+
+    // Disconnecting counts as releasing
+    other.disconnectFromServer();
+    QElapsedTimer timer;
+    timer.start();
+    while (shmExists(name) && timer.elapsed() < 5000) {
+        QTest::qWait(5);
+    }
+    QVERIFY(!shmExists(name));
+}
+
+void VolumeServerTest::listenRefusesLiveServerName() {
+    VolumeServer second(m_dicomManager);
+    QVERIFY(!second.listen(m_tempDir.filePath("volume.sock")));
+
+    // The running server keeps its socket
+    QLocalSocket client;
+    client.connectToServer(m_server->serverName());
+    QVERIFY(client.waitForConnected(5000));
+    QCOMPARE(send(client, QJsonObject{{"cmd", "info"}}).value("ok").toBool(), true);
+}
+
+void VolumeServerTest::errorReplies_data() {
+    QTest::addColumn<QByteArray>("request");
+    QTest::addColumn<QString>("error");
+
+    QTest::newRow("negative timepoint") << QByteArray(R"({"cmd":"timepoint","index":-1})") << QString("out of range");
+    QTest::newRow("timepoint past end") << QByteArray(R"({"cmd":"timepoint","index":)" + QByteArray::number(m_spec.timepoints) + "}") << QString("out of range");
+    QTest::newRow("missing timepoint index") << QByteArray(R"({"cmd":"timepoint"})") << QString("out of range");
+    QTest::newRow("bad slice") << QByteArray(R"({"cmd":"set_contour","timepoint":0,"slice":99,"x":[1,2],"y":[1,2]})")
+                               << QString("out of range");
+    QTest::newRow("mismatched x/y") << QByteArray(R"({"cmd":"set_contour","timepoint":0,"slice":0,"x":[1,2,3],"y":[1,2]})")
+                                    << QString("same number of points");
+    QTest::newRow("too few points") << QByteArray(R"({"cmd":"set_contour","timepoint":0,"slice":0,"x":[1],"y":[1]})")
+                                    << QString("same number of points");
+    QTest::newRow("malformed json") << QByteArray(R"({"cmd":"info")") << QString("malformed request");
+    QTest::newRow("not an object") << QByteArray(R"([1,2,3])") << QString("malformed request");
+    QTest::newRow("unknown cmd") << QByteArray(R"({"cmd":"frobnicate"})") << QString("unknown command: frobnicate");
+    QTest::newRow("unpublished release") << QByteArray(R"({"cmd":"release","index":9})") << QString("not published");
+}
+
+void VolumeServerTest::errorReplies() {
+    QFETCH(QByteArray, request);
+    QFETCH(QString, error);
+
+    QJsonObject response = send(request);
+    QCOMPARE(response.value("ok").toBool(true), false);
+    QVERIFY2(response.value("error").toString().contains(error),
+             qPrintable("unexpected error: " + response.value("error").toString()));
+}
+
+QTEST_GUILESS_MAIN(VolumeServerTest)
+#include "VolumeServerTest.moc"